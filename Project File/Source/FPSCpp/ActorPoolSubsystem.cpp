@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ActorPoolSubsystem.h"
+#include "FPSCpp.h"
+#include "PooledActor.h"
+#include "FPSCppMemory.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actor Pool Hits"), STAT_ActorPoolHits, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actor Pool Misses"), STAT_ActorPoolMisses, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actor Pool Free Actors"), STAT_ActorPoolFree, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actor Pool Deferred Releases"), STAT_ActorPoolDeferred, STATGROUP_FPSCpp);
+
+void UActorPoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UActorPoolSubsystem::OnWorldPostActorTick);
+}
+
+void UActorPoolSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	DeferredReleases.Reset();
+
+	int32 NumFree = 0;
+	for (const auto& Pair : Pools)
+	{
+		NumFree += Pair.Value.FreeActors.Num();
+	}
+	DEC_DWORD_STAT_BY(STAT_ActorPoolFree, NumFree);
+
+	Pools.Reset();
+	Super::Deinitialize();
+}
+
+AActor* UActorPoolSubsystem::AcquireActor(UClass* Class, const FTransform& Transform,
+                                          const FActorSpawnParameters& SpawnParameters)
+{
+	UWorld* World = GetWorld();
+	if (!Class || !World)
+	{
+		return nullptr;
+	}
+
+	if (FActorPoolBucket* Bucket = Pools.Find(Class))
+	{
+		while (Bucket->FreeActors.Num() > 0)
+		{
+			AActor* Actor = Bucket->FreeActors.Pop(false);
+			DEC_DWORD_STAT(STAT_ActorPoolFree);
+			if (!IsValid(Actor))
+			{
+				continue;
+			}
+
+			Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Actor->SetOwner(SpawnParameters.Owner);
+			Actor->SetInstigator(SpawnParameters.Instigator);
+			Cast<IPooledActor>(Actor)->OnPooledActivate();
+
+			Stats.Hits++;
+			INC_DWORD_STAT(STAT_ActorPoolHits);
+			return Actor;
+		}
+	}
+
+	Stats.Misses++;
+	INC_DWORD_STAT(STAT_ActorPoolMisses);
+
+	// 新生成的actor和它的组件、物理体记到对应的LLM标签下
+	EFPSCppLLMTag Tag;
+	if (FFPSCppMemory::TryGetTagForClass(Class, Tag))
+	{
+		FPSCPP_LLM_SCOPE(Tag);
+		return World->SpawnActor(Class, &Transform, SpawnParameters);
+	}
+	return World->SpawnActor(Class, &Transform, SpawnParameters);
+}
+
+void UActorPoolSubsystem::Release(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	IPooledActor* PooledActor = Cast<IPooledActor>(Actor);
+	if (!PooledActor)
+	{
+		Actor->Destroy();
+		return;
+	}
+
+	FActorPoolBucket& Bucket = Pools.FindOrAdd(Actor->GetClass());
+	if (Bucket.FreeActors.Contains(Actor))
+	{
+		return;
+	}
+
+	PooledActor->OnPooledDeactivate();
+	Bucket.FreeActors.Add(Actor);
+	Stats.Released++;
+	INC_DWORD_STAT(STAT_ActorPoolFree);
+}
+
+void UActorPoolSubsystem::ReleaseDeferred(AActor* Actor)
+{
+	if (IsValid(Actor))
+	{
+		DeferredReleases.AddUnique(Actor);
+	}
+}
+
+void UActorPoolSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || DeferredReleases.Num() == 0)
+	{
+		return;
+	}
+
+	// 帧末统一回收, 超出预算的留到下一帧, 避免一波死亡集中在同一帧销毁
+	const int32 NumReleases = FMath::Min(DeferredReleases.Num(), FMath::Max(MaxDeferredReleasesPerFrame, 1));
+	for (int32 Index = 0; Index < NumReleases; ++Index)
+	{
+		Release(DeferredReleases[Index].Get());
+	}
+	DeferredReleases.RemoveAt(0, NumReleases, false);
+	INC_DWORD_STAT_BY(STAT_ActorPoolDeferred, NumReleases);
+}
+
+void UActorPoolSubsystem::Prewarm(UClass* Class, int32 Count)
+{
+	UWorld* World = GetWorld();
+	if (!Class || !World || !Class->ImplementsInterface(UPooledActor::StaticClass()))
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 Index = GetNumFree(Class); Index < Count; ++Index)
+	{
+		AActor* Actor = World->SpawnActor(Class, &FTransform::Identity, SpawnParameters);
+		if (Actor)
+		{
+			Release(Actor);
+			Stats.Prewarmed++;
+		}
+	}
+}
+
+int32 UActorPoolSubsystem::GetNumFree(UClass* Class) const
+{
+	const FActorPoolBucket* Bucket = Pools.Find(Class);
+	return Bucket ? Bucket->FreeActors.Num() : 0;
+}
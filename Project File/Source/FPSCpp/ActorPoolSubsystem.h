@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ActorPoolSubsystem.generated.h"
+
+USTRUCT()
+struct FActorPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AActor*> FreeActors;
+};
+
+struct FActorPoolStats
+{
+	int32 Hits = 0;
+	int32 Misses = 0;
+	int32 Released = 0;
+	int32 Prewarmed = 0;
+};
+
+/**
+ * Keeps deactivated actors per class and hands them out again instead of spawning and destroying.
+ * Only actors implementing IPooledActor are pooled, anything else is spawned and destroyed normally.
+ */
+UCLASS(config=Game)
+class FPSCPP_API UActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	AActor* AcquireActor(UClass* Class, const FTransform& Transform,
+	                     const FActorSpawnParameters& SpawnParameters = FActorSpawnParameters());
+
+	template <class T>
+	T* Acquire(TSubclassOf<T> Class, const FTransform& Transform,
+	           const FActorSpawnParameters& SpawnParameters = FActorSpawnParameters())
+	{
+		return Cast<T>(AcquireActor(Class, Transform, SpawnParameters));
+	}
+
+	void Release(AActor* Actor);
+
+	/** Releases the actor at the end of the frame, at most MaxDeferredReleasesPerFrame per frame */
+	void ReleaseDeferred(AActor* Actor);
+
+	/** Spawns Count actors of Class into the pool, e.g. at match start */
+	void Prewarm(UClass* Class, int32 Count);
+
+	int32 GetNumFree(UClass* Class) const;
+
+	const FActorPoolStats& GetStats() const { return Stats; }
+
+	int32 GetNumDeferred() const { return DeferredReleases.Num(); }
+
+	/** Spreads large death waves over several frames */
+	UPROPERTY(config)
+	int32 MaxDeferredReleasesPerFrame = 8;
+
+private:
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	TArray<TWeakObjectPtr<AActor>> DeferredReleases;
+
+	FDelegateHandle PostActorTickHandle;
+
+	UPROPERTY()
+	TMap<UClass*, FActorPoolBucket> Pools;
+
+	FActorPoolStats Stats;
+};
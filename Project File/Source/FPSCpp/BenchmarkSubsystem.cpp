@@ -0,0 +1,524 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BenchmarkSubsystem.h"
+#include "FPSCpp.h"
+#include "ActorPoolSubsystem.h"
+#include "FPSCppCharacter.h"
+#include "GameplayTimerSubsystem.h"
+#include "Grenade.h"
+#include "HealthComponent.h"
+#include "HealthSubsystem.h"
+#include "Target.h"
+#include "TargetField.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "Misc/CommandLine.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+
+CSV_DEFINE_CATEGORY(FPSCppBench, true);
+
+template <typename T>
+static void ReleaseAll(UWorld* World, TArray<T*>& Actors)
+{
+	UActorPoolSubsystem* ActorPool = World->GetSubsystem<UActorPoolSubsystem>();
+	for (T* Actor : Actors)
+	{
+		if (!IsValid(Actor))
+		{
+			continue;
+		}
+		if (ActorPool)
+		{
+			ActorPool->Release(Actor);
+		}
+		else
+		{
+			Actor->Destroy();
+		}
+	}
+	Actors.Reset();
+}
+
+void UBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (GetWorld()->IsGameWorld() && FParse::Param(FCommandLine::Get(), TEXT("FPSCppBench")))
+	{
+		bExitWhenDone = true;
+		Run(TArray<FString>(), false);
+	}
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UBenchmarkSubsystem::OnWorldPostActorTick);
+}
+
+void UBenchmarkSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	Super::Deinitialize();
+}
+
+const TCHAR* UBenchmarkSubsystem::GetScenarioName(EScenario Scenario)
+{
+	switch (Scenario)
+	{
+	case EScenario::Fire: return TEXT("Fire");
+	case EScenario::Grenades: return TEXT("Grenades");
+	case EScenario::Targets: return TEXT("Targets");
+	case EScenario::Health: return TEXT("Health");
+	default: return TEXT("Unknown");
+	}
+}
+
+void UBenchmarkSubsystem::Run(const TArray<FString>& ScenarioNames, bool bSaveBaseline)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogFPSCpp, Warning, TEXT("Benchmark already running"));
+		return;
+	}
+
+	Scenarios.Reset();
+	for (uint8 Index = 0; Index < static_cast<uint8>(EScenario::Num); ++Index)
+	{
+		const EScenario Scenario = static_cast<EScenario>(Index);
+		const bool bWanted = ScenarioNames.Num() == 0 || ScenarioNames.ContainsByPredicate([Scenario](const FString& Name)
+		{
+			return Name.Equals(GetScenarioName(Scenario), ESearchCase::IgnoreCase);
+		});
+		if (bWanted)
+		{
+			Scenarios.Add(Scenario);
+		}
+	}
+
+	CurrentScenario = 0;
+	ScenarioFrame = 0;
+	Results.Reset();
+	bSaveResults = bSaveBaseline;
+	bFailed = false;
+	Random.Initialize(0);
+
+#if CSV_PROFILER
+	if (!FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture();
+		bStartedCsvCapture = true;
+	}
+#endif
+}
+
+void UBenchmarkSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || !IsRunning() || !World->HasBegunPlay() || !World->GetAuthGameMode())
+	{
+		return;
+	}
+
+	const EScenario Scenario = Scenarios[CurrentScenario];
+	if (ScenarioFrame == 0)
+	{
+		// 准备帧不计时, 生成的actor下一帧再测
+		SetupScenario(Scenario);
+		FrameSeconds.Reset();
+		ScenarioFrame++;
+		return;
+	}
+
+	const double Seconds = RunScenario(Scenario);
+	FrameSeconds.Add(Seconds);
+#if CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(FName(GetScenarioName(Scenario)), CSV_CATEGORY_INDEX(FPSCppBench), Seconds * 1000.0,
+	                               ECsvCustomStatOp::Set);
+#endif
+
+	if (ScenarioFrame++ < FramesPerScenario)
+	{
+		return;
+	}
+
+	TeardownScenario(Scenario);
+
+	FResult& Result = Results.AddDefaulted_GetRef();
+	Result.Scenario = Scenario;
+	Result.AverageMs = 0.0;
+	Result.WorstMs = 0.0;
+	for (const double FrameSecond : FrameSeconds)
+	{
+		Result.AverageMs += FrameSecond * 1000.0;
+		Result.WorstMs = FMath::Max(Result.WorstMs, FrameSecond * 1000.0);
+	}
+	Result.AverageMs /= FMath::Max(FrameSeconds.Num(), 1);
+
+	CurrentScenario++;
+	ScenarioFrame = 0;
+	if (!IsRunning())
+	{
+		Finish();
+	}
+}
+
+void UBenchmarkSubsystem::SpawnPawns(TArray<AFPSCppCharacter*>& OutPawns, int32 Count)
+{
+	UWorld* World = GetWorld();
+	UActorPoolSubsystem* ActorPool = World->GetSubsystem<UActorPoolSubsystem>();
+	UClass* PawnClass = World->GetAuthGameMode()->DefaultPawnClass;
+	if (!ActorPool || !PawnClass || !PawnClass->IsChildOf<AFPSCppCharacter>())
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	// 按方阵摆放, 间距150
+	const int32 Side = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Offset((Index % Side - Side / 2) * 150.f, (Index / Side - Side / 2) * 150.f, 0.f);
+		if (AFPSCppCharacter* Pawn = ActorPool->Acquire<AFPSCppCharacter>(PawnClass, FTransform(Origin + Offset), SpawnParams))
+		{
+			OutPawns.Add(Pawn);
+		}
+	}
+}
+
+void UBenchmarkSubsystem::SetupScenario(EScenario Scenario)
+{
+	UWorld* World = GetWorld();
+	if (AActor* PlayerStart = World->GetAuthGameMode()->FindPlayerStart(nullptr))
+	{
+		Origin = PlayerStart->GetActorLocation();
+	}
+
+	switch (Scenario)
+	{
+	case EScenario::Fire:
+	case EScenario::Grenades:
+		SpawnPawns(Pawns, Scenario == EScenario::Fire ? 1 : PawnCount);
+		if (Scenario == EScenario::Fire)
+		{
+			// 同步射线, 追踪的耗时计在OnFire里
+			if (IConsoleVariable* HitscanAsync = IConsoleManager::Get().FindConsoleVariable(TEXT("fpscpp.Hitscan.Async")))
+			{
+				PreviousHitscanAsync = HitscanAsync->GetInt();
+				HitscanAsync->Set(0, ECVF_SetByCode);
+			}
+		}
+		break;
+	case EScenario::Targets:
+		{
+			// 自己生成靶场, 不依赖关卡里摆放的靶场, 不同地图的结果也能比较
+			UClass* FieldTargetClass = TargetClass.LoadSynchronous();
+			if (!FieldTargetClass)
+			{
+				UE_LOG(LogFPSCpp, Error, TEXT("Benchmark Targets: TargetClass %s could not be loaded"), *TargetClass.ToString());
+				break;
+			}
+			const FTransform FieldTransform(Origin + FVector(300.f, 0.f, 0.f));
+			Field = World->SpawnActorDeferred<ATargetField>(ATargetField::StaticClass(), FieldTransform, nullptr, nullptr,
+			                                                ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (Field)
+			{
+				Field->TargetClass = FieldTargetClass;
+				for (int32 Index = 0; Index < TargetCount; ++Index)
+				{
+					Field->TargetTransforms.Add(FTransform(FVector(0.f, (Index - TargetCount / 2) * 100.f, 0.f)));
+				}
+				Field->FinishSpawning(FieldTransform);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+double UBenchmarkSubsystem::RunScenario(EScenario Scenario)
+{
+	UWorld* World = GetWorld();
+	double Seconds = 0.0;
+
+	switch (Scenario)
+	{
+	case EScenario::Fire:
+		if (AFPSCppCharacter* Shooter = Pawns.Num() > 0 ? Pawns[0] : nullptr)
+		{
+			CSV_SCOPED_TIMING_STAT(FPSCppBench, Fire);
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Index = 0; Index < ShotsPerFrame; ++Index)
+			{
+				Shooter->CurrentAmmo = 2;
+				Shooter->bAbleToFire = true;
+				Shooter->OnFire();
+			}
+			Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+		break;
+	case EScenario::Grenades:
+		{
+			AFPSCppCharacter* Thrower = Pawns.Num() > 0 ? Pawns[0] : nullptr;
+			UActorPoolSubsystem* ActorPool = World->GetSubsystem<UActorPoolSubsystem>();
+			if (!Thrower || !Thrower->GrenadeClass || !ActorPool)
+			{
+				break;
+			}
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			TArray<AGrenade*, TInlineAllocator<64>> Grenades;
+			const float Extent = FMath::Sqrt(static_cast<float>(PawnCount)) * 75.f;
+			for (int32 Index = 0; Index < GrenadeCount; ++Index)
+			{
+				const FVector Location = Origin + FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), 50.f);
+				if (AGrenade* Grenade = ActorPool->Acquire<AGrenade>(Thrower->GrenadeClass, FTransform(Location), SpawnParams))
+				{
+					Grenades.Add(Grenade);
+				}
+			}
+
+			CSV_SCOPED_TIMING_STAT(FPSCppBench, Grenades);
+			const double StartTime = FPlatformTime::Seconds();
+			for (AGrenade* Grenade : Grenades)
+			{
+				Grenade->Explore();
+			}
+			Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+		break;
+	case EScenario::Targets:
+		if (Field && Field->TargetTransforms.Num() > 0)
+		{
+			// 命中实例换成池里的靶子, 再复活收回成实例, 和对局里的路径一样
+			UGameplayTimerSubsystem* Timers = World->GetSubsystem<UGameplayTimerSubsystem>();
+			FHitResult Hit(Field, Field->TargetInstances, Field->GetActorLocation(), FVector::UpVector);
+			CSV_SCOPED_TIMING_STAT(FPSCppBench, Targets);
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Cycle = 0; Cycle < TargetCycles; ++Cycle)
+			{
+				const int32 Index = Cycle % Field->TargetTransforms.Num();
+				Hit.Item = Index;
+				Field->ReceiveDamage(0.f, Hit, nullptr);
+				if (ATarget* Target = Field->ActiveTargets.IsValidIndex(Index) ? Field->ActiveTargets[Index] : nullptr)
+				{
+					if (Timers)
+					{
+						Timers->ClearTimer(Target->RebornTimerHandle);
+					}
+					Target->Reborn();
+				}
+			}
+			Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+		break;
+	case EScenario::Health:
+		{
+			// 上一帧死掉的放回池子, 再取一批满血的
+			ReleaseAll(World, Victims);
+			SpawnPawns(Victims, DeathCount);
+			UHealthSubsystem* Health = World->GetSubsystem<UHealthSubsystem>();
+			if (!Health)
+			{
+				break;
+			}
+
+			CSV_SCOPED_TIMING_STAT(FPSCppBench, Health);
+			const double StartTime = FPlatformTime::Seconds();
+			for (AFPSCppCharacter* Victim : Victims)
+			{
+				Victim->HealthComponent->ChangeHealth(1000000.f);
+			}
+			Health->ApplyPendingDamage();
+			Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return Seconds;
+}
+
+void UBenchmarkSubsystem::TeardownScenario(EScenario Scenario)
+{
+	UWorld* World = GetWorld();
+	if (Scenario == EScenario::Fire)
+	{
+		if (IConsoleVariable* HitscanAsync = IConsoleManager::Get().FindConsoleVariable(TEXT("fpscpp.Hitscan.Async")))
+		{
+			HitscanAsync->Set(PreviousHitscanAsync, ECVF_SetByCode);
+		}
+	}
+	ReleaseAll(World, Pawns);
+	ReleaseAll(World, Victims);
+	if (Field)
+	{
+		Field->Destroy();
+		Field = nullptr;
+	}
+}
+
+void UBenchmarkSubsystem::Finish()
+{
+#if CSV_PROFILER
+	if (bStartedCsvCapture)
+	{
+		FCsvProfiler::Get()->EndCapture();
+		bStartedCsvCapture = false;
+	}
+#endif
+
+	bFailed = false;
+	for (const FResult& Result : Results)
+	{
+		const FName ScenarioName = GetScenarioName(Result.Scenario);
+		FBenchmarkBaseline* Baseline = Baselines.FindByPredicate([ScenarioName](const FBenchmarkBaseline& Entry)
+		{
+			return Entry.Scenario == ScenarioName;
+		});
+
+		// 没测到东西说明场景没跑起来, 和没有基线一样算失败, 保存基线时缺基线是正常的
+		const TCHAR* Verdict;
+		if (Result.AverageMs <= 0.0)
+		{
+			bFailed = true;
+			Verdict = TEXT("FAIL (nothing measured)");
+		}
+		else if (!Baseline || Baseline->AverageMs <= 0.f)
+		{
+			bFailed |= !bSaveResults;
+			Verdict = bSaveResults ? TEXT("NO BASELINE") : TEXT("FAIL (no baseline recorded)");
+		}
+		else
+		{
+			const bool bPassed = Result.AverageMs <= Baseline->AverageMs * (1.f + Tolerance);
+			bFailed |= !bPassed;
+			Verdict = bPassed ? TEXT("PASS") : TEXT("FAIL");
+		}
+		UE_LOG(LogFPSCpp, Display, TEXT("Benchmark %-8s avg %8.3f ms, worst %8.3f ms, baseline %8.3f ms  %s"),
+		       *ScenarioName.ToString(), Result.AverageMs, Result.WorstMs, Baseline ? Baseline->AverageMs : 0.f, Verdict);
+
+		if (bSaveResults && Result.AverageMs > 0.0)
+		{
+			if (!Baseline)
+			{
+				Baseline = &Baselines.AddDefaulted_GetRef();
+				Baseline->Scenario = ScenarioName;
+			}
+			Baseline->AverageMs = Result.AverageMs;
+		}
+	}
+
+	// 编辑器里直接写回DefaultGame.ini, 方便提交新的基线
+	if (bSaveResults)
+	{
+#if WITH_EDITOR
+		UpdateDefaultConfigFile();
+#else
+		SaveConfig();
+#endif
+	}
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkRunCommand(
+	TEXT("fpscpp.Bench.Run"),
+	TEXT("Runs the hot path benchmarks and compares them against the configured baselines. Usage: fpscpp.Bench.Run [Fire] [Grenades] [Targets] [Health] [save]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UBenchmarkSubsystem>() : nullptr;
+		if (!Benchmark || !World->GetAuthGameMode())
+		{
+			UE_LOG(LogFPSCpp, Warning, TEXT("fpscpp.Bench.Run needs a server or standalone game world"));
+			return;
+		}
+		TArray<FString> Names = Args;
+		const bool bSave = Names.RemoveAll([](const FString& Arg) { return Arg == TEXT("save"); }) > 0;
+		Benchmark->Run(Names, bSave);
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Starts one scenario in the loaded game world and reports its verdict once it finished */
+class FRunBenchmarkScenarioCommand : public IAutomationLatentCommand
+{
+public:
+	FRunBenchmarkScenarioCommand(const FString& InScenario, FAutomationTestBase* InTest)
+		: Scenario(InScenario), Test(InTest)
+	{
+	}
+
+	virtual bool Update() override
+	{
+		UWorld* World = nullptr;
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if (Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE)
+			{
+				World = Context.World();
+				break;
+			}
+		}
+		UBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UBenchmarkSubsystem>() : nullptr;
+		if (!Benchmark || !World->GetAuthGameMode())
+		{
+			Test->AddError(TEXT("The benchmark needs a server or standalone game world"));
+			return true;
+		}
+
+		if (!bStarted)
+		{
+			Benchmark->Run({Scenario}, false);
+			bStarted = true;
+			return false;
+		}
+		if (Benchmark->IsRunning())
+		{
+			return false;
+		}
+		if (Benchmark->HasFailed())
+		{
+			Test->AddError(FString::Printf(TEXT("Benchmark %s failed, the verdict is in the LogFPSCpp output"), *Scenario));
+		}
+		return true;
+	}
+
+private:
+	FString Scenario;
+	FAutomationTestBase* Test;
+	bool bStarted = false;
+};
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FFPSCppBenchmarkTest, "FPSCpp.Benchmark",
+                                  EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FFPSCppBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (uint8 Index = 0; Index < static_cast<uint8>(UBenchmarkSubsystem::EScenario::Num); ++Index)
+	{
+		const TCHAR* Name = UBenchmarkSubsystem::GetScenarioName(static_cast<UBenchmarkSubsystem::EScenario>(Index));
+		OutBeautifiedNames.Add(Name);
+		OutTestCommands.Add(Name);
+	}
+}
+
+bool FFPSCppBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const FString& Map = GetDefault<UBenchmarkSubsystem>()->AutomationMap;
+	if (Map.IsEmpty() || !AutomationOpenMap(Map))
+	{
+		AddError(FString::Printf(TEXT("Could not open the benchmark map '%s'"), *Map));
+		return false;
+	}
+	ADD_LATENT_AUTOMATION_COMMAND(FRunBenchmarkScenarioCommand(Parameters, this));
+	return true;
+}
+
+#endif
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BenchmarkSubsystem.generated.h"
+
+class AFPSCppCharacter;
+class ATarget;
+class ATargetField;
+
+USTRUCT()
+struct FBenchmarkBaseline
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Scenario;
+
+	/** Average game thread milliseconds per frame the scenario is expected to stay under */
+	UPROPERTY()
+	float AverageMs = 0.f;
+};
+
+/**
+ * Measures the gameplay hot paths one at a time in a running server or standalone world:
+ * Fire: ShotsPerFrame OnFire calls per frame, traced synchronously.
+ * Grenades: GrenadeCount AGrenade::Explore calls per frame among PawnCount pawns.
+ * Targets: TargetCycles hit/Reborn cycles per frame on a spawned ATargetField of TargetCount TargetClass placements.
+ * Health: DeathCount UHealthComponent deaths per frame.
+ * Each scenario's milliseconds per frame are written to the csv profiler and compared against Baselines.
+ * fpscpp.Bench.Run starts it from the console, -FPSCppBench runs it on start and exits with 1 on a regression,
+ * a scenario without a baseline or a scenario that measured nothing.
+ * Each scenario is also the automation test FPSCpp.Benchmark.<Scenario>, run in -game on AutomationMap.
+ */
+UCLASS(config=Game)
+class FPSCPP_API UBenchmarkSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	enum class EScenario : uint8
+	{
+		Fire,
+		Grenades,
+		Targets,
+		Health,
+		Num
+	};
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Runs the named scenarios, all of them when empty. bSaveBaseline stores the results as the new baselines */
+	void Run(const TArray<FString>& ScenarioNames, bool bSaveBaseline);
+
+	bool IsRunning() const { return CurrentScenario < Scenarios.Num(); }
+
+	static const TCHAR* GetScenarioName(EScenario Scenario);
+
+	/** The last finished run had a regression, a scenario without a baseline or a scenario that measured nothing */
+	bool HasFailed() const { return bFailed; }
+
+	/** Timed frames per scenario, after one untimed setup frame */
+	UPROPERTY(config)
+	int32 FramesPerScenario = 10;
+
+	UPROPERTY(config)
+	int32 ShotsPerFrame = 1000;
+
+	UPROPERTY(config)
+	int32 GrenadeCount = 50;
+
+	UPROPERTY(config)
+	int32 PawnCount = 200;
+
+	UPROPERTY(config)
+	int32 TargetCount = 50;
+
+	UPROPERTY(config)
+	TSoftClassPtr<ATarget> TargetClass;
+
+	UPROPERTY(config)
+	int32 TargetCycles = 500;
+
+	UPROPERTY(config)
+	int32 DeathCount = 100;
+
+	/** A scenario fails when its average is more than this fraction above the baseline */
+	UPROPERTY(config)
+	float Tolerance = 0.2f;
+
+	UPROPERTY(config)
+	TArray<FBenchmarkBaseline> Baselines;
+
+	/** Map the automation tests open before running their scenario */
+	UPROPERTY(config)
+	FString AutomationMap;
+
+private:
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void SetupScenario(EScenario Scenario);
+
+	/** Runs one frame of the scenario and returns the measured seconds */
+	double RunScenario(EScenario Scenario);
+
+	void TeardownScenario(EScenario Scenario);
+
+	void Finish();
+
+	void SpawnPawns(TArray<AFPSCppCharacter*>& OutPawns, int32 Count);
+
+	TArray<EScenario> Scenarios;
+
+	int32 CurrentScenario = 0;
+
+	/** 0 is the setup frame */
+	int32 ScenarioFrame = 0;
+
+	TArray<double> FrameSeconds;
+
+	struct FResult
+	{
+		EScenario Scenario;
+		double AverageMs;
+		double WorstMs;
+	};
+	TArray<FResult> Results;
+
+	bool bSaveResults = false;
+	bool bFailed = false;
+	bool bExitWhenDone = false;
+	bool bStartedCsvCapture = false;
+
+	/** fpscpp.Hitscan.Async before the Fire scenario forced synchronous traces */
+	int32 PreviousHitscanAsync = 1;
+
+	FVector Origin = FVector::ZeroVector;
+
+	FRandomStream Random;
+
+	UPROPERTY(Transient)
+	TArray<AFPSCppCharacter*> Pawns;
+
+	UPROPERTY(Transient)
+	TArray<AFPSCppCharacter*> Victims;
+
+	UPROPERTY(Transient)
+	ATargetField* Field = nullptr;
+
+	FDelegateHandle PostActorTickHandle;
+};
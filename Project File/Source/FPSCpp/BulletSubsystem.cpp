@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BulletSubsystem.h"
+#include "FPSCpp.h"
+#include "FPSCppProjectile.h"
+#include "Async/ParallelFor.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bullet Resolve"), STAT_BulletResolve, STATGROUP_FPSCpp);
+DECLARE_CYCLE_STAT(TEXT("Bullet Integrate"), STAT_BulletIntegrate, STATGROUP_FPSCpp);
+DECLARE_CYCLE_STAT(TEXT("Bullet Issue Sweeps"), STAT_BulletIssueSweeps, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bullets In Flight"), STAT_BulletsInFlight, STATGROUP_FPSCpp);
+
+// 每个并行任务处理的子弹数, 太小时调度开销会超过积分本身
+static constexpr int32 BulletIntegrateBatchSize = 256;
+
+void UBulletSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const int32 InitialCapacity = FMath::Min(MaxBullets, 1024);
+	Positions.Reserve(InitialCapacity);
+	PreviousPositions.Reserve(InitialCapacity);
+	Velocities.Reserve(InitialCapacity);
+	Ages.Reserve(InitialCapacity);
+	BulletTypes.Reserve(InitialCapacity);
+	Instigators.Reserve(InitialCapacity);
+	TraceHandles.Reserve(InitialCapacity);
+}
+
+void UBulletSubsystem::Deinitialize()
+{
+	SET_DWORD_STAT(STAT_BulletsInFlight, 0);
+	Super::Deinitialize();
+}
+
+bool UBulletSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && Positions.Num() > 0;
+}
+
+TStatId UBulletSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBulletSubsystem, STATGROUP_Tickables);
+}
+
+bool UBulletSubsystem::FireBullet(TSubclassOf<AFPSCppProjectile> ProjectileClass, const FVector& Origin,
+                                  const FVector& Direction, AActor* Instigator)
+{
+	if (!ProjectileClass || Positions.Num() >= MaxBullets)
+	{
+		return false;
+	}
+
+	const int32 TypeIndex = FindOrAddType(ProjectileClass);
+	if (TypeIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	Positions.Add(Origin);
+	PreviousPositions.Add(Origin);
+	Velocities.Add(Direction.GetSafeNormal() * Types[TypeIndex].Speed);
+	Ages.Add(0.f);
+	BulletTypes.Add(static_cast<uint8>(TypeIndex));
+	Instigators.Add(Instigator);
+	TraceHandles.AddDefaulted();
+	return true;
+}
+
+int32 UBulletSubsystem::FindOrAddType(TSubclassOf<AFPSCppProjectile> ProjectileClass)
+{
+	if (const int32* Found = TypeIndices.Find(ProjectileClass.Get()))
+	{
+		return *Found;
+	}
+
+	if (Types.Num() > MAX_uint8)
+	{
+		return INDEX_NONE;
+	}
+
+	const AFPSCppProjectile* Defaults = ProjectileClass->GetDefaultObject<AFPSCppProjectile>();
+
+	FBulletType Type;
+	Type.ProjectileClass = ProjectileClass;
+	Type.HitParticle = Defaults->GetHitParticle();
+	Type.Speed = Defaults->GetProjectileMovement()->InitialSpeed;
+	Type.GravityScale = Defaults->GetProjectileMovement()->ProjectileGravityScale;
+	Type.DragCoefficient = Defaults->DragCoefficient;
+	Type.Radius = Defaults->GetCollisionComp()->GetUnscaledSphereRadius();
+	Type.LifeSpan = Defaults->LifeSpan > 0.f ? Defaults->LifeSpan : 3.f;
+	Type.Damage = Defaults->Damage;
+
+	const int32 TypeIndex = Types.Add(Type);
+	TypeIndices.Add(ProjectileClass.Get(), TypeIndex);
+	return TypeIndex;
+}
+
+void UBulletSubsystem::Tick(float DeltaTime)
+{
+	GravityZ = GetWorld()->GetGravityZ();
+
+	ResolveTraces();
+	Integrate(DeltaTime);
+	IssueTraces();
+
+	SET_DWORD_STAT(STAT_BulletsInFlight, Positions.Num());
+}
+
+void UBulletSubsystem::ResolveTraces()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletResolve);
+
+	UWorld* World = GetWorld();
+
+	// 倒序遍历, 交换删除不会跳过未处理的子弹
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		const FBulletType& Type = Types[BulletTypes[Index]];
+		bool bRemove = Ages[Index] >= Type.LifeSpan;
+
+		FTraceDatum TraceDatum;
+		if (TraceHandles[Index].IsValid() && World->QueryTraceData(TraceHandles[Index], TraceDatum))
+		{
+			for (const FHitResult& Hit : TraceDatum.OutHits)
+			{
+				if (Hit.bBlockingHit)
+				{
+					AFPSCppProjectile::ApplyImpact(World, Hit, Velocities[Index], Hit.Location, Type.HitParticle,
+					                               Type.Damage, Instigators[Index].Get());
+					bRemove = true;
+					break;
+				}
+			}
+		}
+
+		if (bRemove)
+		{
+			RemoveBullet(Index);
+		}
+	}
+}
+
+void UBulletSubsystem::Integrate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletIntegrate);
+
+	const int32 NumBullets = Positions.Num();
+	const int32 NumBatches = FMath::DivideAndRoundUp(NumBullets, BulletIntegrateBatchSize);
+
+	ParallelFor(NumBatches, [this, DeltaTime, NumBullets](int32 Batch)
+	{
+		const int32 First = Batch * BulletIntegrateBatchSize;
+		const int32 Last = FMath::Min(First + BulletIntegrateBatchSize, NumBullets);
+
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			const FBulletType& Type = Types[BulletTypes[Index]];
+			FVector& Velocity = Velocities[Index];
+
+			// 重力 + 与速度平方成正比的空气阻力
+			const FVector Acceleration = FVector(0.f, 0.f, GravityZ * Type.GravityScale)
+				- Velocity * (Velocity.Size() * Type.DragCoefficient);
+			Velocity += Acceleration * DeltaTime;
+
+			PreviousPositions[Index] = Positions[Index];
+			Positions[Index] += Velocity * DeltaTime;
+			Ages[Index] += DeltaTime;
+		}
+	});
+}
+
+void UBulletSubsystem::IssueTraces()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletIssueSweeps);
+
+	UWorld* World = GetWorld();
+
+	for (int32 Index = 0; Index < Positions.Num(); ++Index)
+	{
+		const FBulletType& Type = Types[BulletTypes[Index]];
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(BulletSweep), false, Instigators[Index].Get());
+		TraceHandles[Index] = World->AsyncSweepByChannel(EAsyncTraceType::Single, PreviousPositions[Index],
+		                                                 Positions[Index], FQuat::Identity, TraceChannel,
+		                                                 FCollisionShape::MakeSphere(Type.Radius), Params);
+	}
+}
+
+void UBulletSubsystem::RemoveBullet(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	PreviousPositions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Ages.RemoveAtSwap(Index, 1, false);
+	BulletTypes.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	TraceHandles.RemoveAtSwap(Index, 1, false);
+}
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BulletSubsystem.generated.h"
+
+class AFPSCppProjectile;
+class UParticleSystem;
+
+/** Ballistic settings shared by every bullet fired from the same projectile class */
+USTRUCT()
+struct FBulletType
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<AFPSCppProjectile> ProjectileClass;
+
+	UPROPERTY()
+	UParticleSystem* HitParticle = nullptr;
+
+	float Speed = 3000.f;
+	float GravityScale = 1.f;
+	float DragCoefficient = 0.f;
+	float Radius = 5.f;
+	float LifeSpan = 3.f;
+	float Damage = 0.f;
+};
+
+/**
+ * Simulates bullets without actors. Bullet state lives in parallel arrays, is integrated in a
+ * ParallelFor and swept against the world in the async trace batch, so thousands of bullets
+ * cost no actor spawns, components or ticks. Impacts run the same logic as AFPSCppProjectile::OnHit.
+ */
+UCLASS(config=Game)
+class FPSCPP_API UBulletSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	/** Fires a bullet using the ballistic settings of ProjectileClass' default object */
+	bool FireBullet(TSubclassOf<AFPSCppProjectile> ProjectileClass, const FVector& Origin, const FVector& Direction,
+	                AActor* Instigator);
+
+	int32 GetNumBullets() const { return Positions.Num(); }
+
+	UPROPERTY(config)
+	int32 MaxBullets = 8192;
+
+	/** Projectile object channel, bullets collide with whatever blocks the Projectile profile */
+	UPROPERTY(config)
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_GameTraceChannel1;
+
+private:
+	int32 FindOrAddType(TSubclassOf<AFPSCppProjectile> ProjectileClass);
+
+	void ResolveTraces();
+
+	void Integrate(float DeltaTime);
+
+	void IssueTraces();
+
+	void RemoveBullet(int32 Index);
+
+	UPROPERTY()
+	TArray<FBulletType> Types;
+
+	TMap<UClass*, int32> TypeIndices;
+
+	TArray<FVector> Positions;
+	TArray<FVector> PreviousPositions;
+	TArray<FVector> Velocities;
+	TArray<float> Ages;
+	TArray<uint8> BulletTypes;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+	TArray<FTraceHandle> TraceHandles;
+
+	float GravityZ = -980.f;
+};
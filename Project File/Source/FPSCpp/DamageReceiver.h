@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "DamageReceiver.generated.h"
+
+UINTERFACE(MinimalAPI)
+class UDamageReceiver : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Anything that can be shot or blown up. Implementers register themselves with
+ * UDamageRegistrySubsystem in BeginPlay so hits resolve without walking the component list.
+ */
+class FPSCPP_API IDamageReceiver
+{
+	GENERATED_BODY()
+
+public:
+	virtual void ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser) = 0;
+};
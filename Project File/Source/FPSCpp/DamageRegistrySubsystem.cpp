@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageRegistrySubsystem.h"
+#include "FPSCpp.h"
+#include "DamageReceiver.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Receiver Lookups"), STAT_DamageReceiverLookups, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Receiver Components Scanned"), STAT_DamageReceiverComponentsScanned, STATGROUP_FPSCpp);
+
+static TAutoConsoleVariable<int32> CVarDamageRegistryEnable(
+	TEXT("fpscpp.DamageRegistry.Enable"),
+	1,
+	TEXT("1: resolve damage receivers through the registry.\n")
+	TEXT("0: scan the hit actor's components on every lookup."),
+	ECVF_Default);
+
+void UDamageRegistrySubsystem::Deinitialize()
+{
+	Receivers.Reset();
+	Super::Deinitialize();
+}
+
+bool UDamageRegistrySubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UDamageRegistrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageRegistrySubsystem, STATGROUP_Tickables);
+}
+
+void UDamageRegistrySubsystem::Tick(float DeltaTime)
+{
+	LookupsLastFrame = Lookups;
+	ComponentsScannedLastFrame = ComponentsScanned;
+	Lookups = 0;
+	ComponentsScanned = 0;
+}
+
+void UDamageRegistrySubsystem::Register(AActor* Actor, UObject* ReceiverObject)
+{
+	if (!Actor || !ReceiverObject)
+	{
+		return;
+	}
+
+	IDamageReceiver* Receiver = Cast<IDamageReceiver>(ReceiverObject);
+	if (!ensureMsgf(Receiver, TEXT("%s does not implement IDamageReceiver"), *ReceiverObject->GetName()))
+	{
+		return;
+	}
+
+	Receivers.Add(FObjectKey(Actor), FReceiverEntry{ReceiverObject, Receiver});
+}
+
+void UDamageRegistrySubsystem::Unregister(AActor* Actor, UObject* ReceiverObject)
+{
+	const FObjectKey Key(Actor);
+	const FReceiverEntry* Entry = Receivers.Find(Key);
+	if (Entry && Entry->Object.Get() == ReceiverObject)
+	{
+		Receivers.Remove(Key);
+	}
+}
+
+IDamageReceiver* UDamageRegistrySubsystem::FindReceiver(AActor* Actor)
+{
+	if (!Actor)
+	{
+		return nullptr;
+	}
+
+	Lookups++;
+	INC_DWORD_STAT(STAT_DamageReceiverLookups);
+
+	if (CVarDamageRegistryEnable.GetValueOnGameThread() == 0)
+	{
+		return FindReceiverByScan(Actor);
+	}
+
+	const FReceiverEntry* Entry = Receivers.Find(FObjectKey(Actor));
+	if (Entry && Entry->Object.IsValid())
+	{
+		return Entry->Receiver;
+	}
+	return nullptr;
+}
+
+IDamageReceiver* UDamageRegistrySubsystem::FindReceiverByScan(AActor* Actor)
+{
+	if (IDamageReceiver* Receiver = Cast<IDamageReceiver>(Actor))
+	{
+		return Receiver;
+	}
+
+	ComponentsScanned += Actor->GetComponents().Num();
+	INC_DWORD_STAT_BY(STAT_DamageReceiverComponentsScanned, Actor->GetComponents().Num());
+	return Cast<IDamageReceiver>(Actor->FindComponentByInterface(UDamageReceiver::StaticClass()));
+}
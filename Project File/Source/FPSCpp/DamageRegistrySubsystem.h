@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DamageRegistrySubsystem.generated.h"
+
+class IDamageReceiver;
+
+/**
+ * Maps a hit actor to its damage receiver in O(1).
+ * fpscpp.DamageRegistry.Enable 0 falls back to the old component scan so both can be compared.
+ */
+UCLASS()
+class FPSCPP_API UDamageRegistrySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	/** ReceiverObject must implement IDamageReceiver, either the actor itself or one of its components */
+	void Register(AActor* Actor, UObject* ReceiverObject);
+
+	void Unregister(AActor* Actor, UObject* ReceiverObject);
+
+	IDamageReceiver* FindReceiver(AActor* Actor);
+
+	int32 GetLookupsLastFrame() const { return LookupsLastFrame; }
+
+	int32 GetComponentsScannedLastFrame() const { return ComponentsScannedLastFrame; }
+
+private:
+	struct FReceiverEntry
+	{
+		TWeakObjectPtr<UObject> Object;
+		IDamageReceiver* Receiver;
+	};
+
+	IDamageReceiver* FindReceiverByScan(AActor* Actor);
+
+	TMap<FObjectKey, FReceiverEntry> Receivers;
+
+	int32 Lookups = 0;
+	int32 ComponentsScanned = 0;
+	int32 LookupsLastFrame = 0;
+	int32 ComponentsScannedLastFrame = 0;
+};
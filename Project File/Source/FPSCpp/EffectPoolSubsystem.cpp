@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EffectPoolSubsystem.h"
+#include "FPSCpp.h"
+#include "FPSCppMemory.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Active"), STAT_EffectPoolActive, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Components"), STAT_EffectPoolComponents, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Pool Recycled"), STAT_EffectPoolRecycled, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Pool Stolen"), STAT_EffectPoolStolen, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Pool Culled"), STAT_EffectPoolCulled, STATGROUP_FPSCpp);
+
+void UEffectPoolSubsystem::Deinitialize()
+{
+	for (auto& Pair : Pools)
+	{
+		for (FPooledEffect& Entry : Pair.Value.Entries)
+		{
+			if (Entry.Component)
+			{
+				Entry.Component->DestroyComponent();
+			}
+		}
+	}
+	Pools.Reset();
+
+	DEC_DWORD_STAT_BY(STAT_EffectPoolActive, Stats.Active);
+	DEC_DWORD_STAT_BY(STAT_EffectPoolComponents, Stats.Pooled);
+	Stats = FEffectPoolStats();
+
+	Super::Deinitialize();
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::SpawnAtLocation(UParticleSystem* Template, const FVector& Location,
+                                                                const FRotator& Rotation, const FVector& Scale)
+{
+	FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Effects);
+	UParticleSystemComponent* Component = Acquire(Template, Location);
+	if (Component)
+	{
+		if (Component->GetAttachParent())
+		{
+			Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		}
+		Component->SetWorldLocationAndRotation(Location, Rotation);
+		Component->SetWorldScale3D(Scale);
+		Component->ActivateSystem(true);
+	}
+	return Component;
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::SpawnAttached(UParticleSystem* Template,
+                                                              USceneComponent* AttachToComponent, FName AttachPointName,
+                                                              const FVector& Location, const FRotator& Rotation,
+                                                              const FVector& Scale)
+{
+	if (!AttachToComponent)
+	{
+		return nullptr;
+	}
+
+	FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Effects);
+	UParticleSystemComponent* Component = Acquire(Template, AttachToComponent->GetComponentLocation());
+	if (Component)
+	{
+		Component->AttachToComponent(AttachToComponent, FAttachmentTransformRules::KeepRelativeTransform,
+		                             AttachPointName);
+		Component->SetRelativeLocationAndRotation(Location, Rotation);
+		Component->SetRelativeScale3D(Scale);
+		Component->ActivateSystem(true);
+	}
+	return Component;
+}
+
+void UEffectPoolSubsystem::Prewarm(UParticleSystem* Template, int32 Count)
+{
+	UWorld* World = GetWorld();
+	if (!Template || !World || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Effects);
+	FEffectPool& Pool = FindOrAddPool(Template);
+	const int32 Target = FMath::Min(Count, Pool.Budget);
+	while (Pool.Entries.Num() < Target)
+	{
+		FPooledEffect Entry;
+		Entry.Component = CreateComponent(Template);
+		Pool.Entries.Add(Entry);
+	}
+}
+
+void UEffectPoolSubsystem::SetBudget(UParticleSystem* Template, int32 Budget)
+{
+	if (Template)
+	{
+		FindOrAddPool(Template).Budget = FMath::Max(Budget, 1);
+	}
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::Acquire(UParticleSystem* Template, const FVector& Location)
+{
+	UWorld* World = GetWorld();
+	if (!Template || !World || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return nullptr;
+	}
+
+	if (IsCulled(Location))
+	{
+		Stats.Culled++;
+		INC_DWORD_STAT(STAT_EffectPoolCulled);
+		return nullptr;
+	}
+
+	FEffectPool& Pool = FindOrAddPool(Template);
+	FPooledEffect* Picked = nullptr;
+	FPooledEffect* Oldest = nullptr;
+
+	for (FPooledEffect& Entry : Pool.Entries)
+	{
+		if (!Entry.bActive)
+		{
+			Picked = &Entry;
+			break;
+		}
+		if (!Oldest || Entry.StartTime < Oldest->StartTime)
+		{
+			Oldest = &Entry;
+		}
+	}
+
+	if (Picked)
+	{
+		Stats.Recycled++;
+		INC_DWORD_STAT(STAT_EffectPoolRecycled);
+	}
+	else if (Pool.Entries.Num() < Pool.Budget)
+	{
+		FPooledEffect Entry;
+		Entry.Component = CreateComponent(Template);
+		Picked = &Pool.Entries.Add_GetRef(Entry);
+	}
+	else
+	{
+		// 池满时回收最早播放的特效
+		Picked = Oldest;
+		Picked->Component->DeactivateImmediate();
+		if (Picked->bActive)
+		{
+			Picked->bActive = false;
+			Stats.Active--;
+			DEC_DWORD_STAT(STAT_EffectPoolActive);
+		}
+		Stats.Stolen++;
+		INC_DWORD_STAT(STAT_EffectPoolStolen);
+	}
+
+	Picked->bActive = true;
+	Picked->StartTime = World->GetTimeSeconds();
+	Stats.Active++;
+	INC_DWORD_STAT(STAT_EffectPoolActive);
+	return Picked->Component;
+}
+
+FEffectPool& UEffectPoolSubsystem::FindOrAddPool(UParticleSystem* Template)
+{
+	FEffectPool* Pool = Pools.Find(Template);
+	if (!Pool)
+	{
+		Pool = &Pools.Add(Template);
+		const int32* ConfigBudget = TemplateBudgets.Find(TSoftObjectPtr<UParticleSystem>(Template));
+		Pool->Budget = FMath::Max(ConfigBudget ? *ConfigBudget : DefaultBudget, 1);
+	}
+	return *Pool;
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::CreateComponent(UParticleSystem* Template)
+{
+	UWorld* World = GetWorld();
+
+	UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(World);
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->SetTemplate(Template);
+	Component->OnSystemFinished.AddDynamic(this, &UEffectPoolSubsystem::OnEffectFinished);
+	Component->RegisterComponentWithWorld(World);
+
+	Stats.Created++;
+	Stats.Pooled++;
+	INC_DWORD_STAT(STAT_EffectPoolComponents);
+	return Component;
+}
+
+bool UEffectPoolSubsystem::IsCulled(const FVector& Location) const
+{
+	if (CullDistance <= 0.f)
+	{
+		return false;
+	}
+
+	bool bHasViewer = false;
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			bHasViewer = true;
+			const FVector ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+			if (FVector::DistSquared(ViewLocation, Location) <= FMath::Square(CullDistance))
+			{
+				return false;
+			}
+		}
+	}
+	return bHasViewer;
+}
+
+void UEffectPoolSubsystem::OnEffectFinished(UParticleSystemComponent* Component)
+{
+	FEffectPool* Pool = Component ? Pools.Find(Component->Template) : nullptr;
+	if (!Pool)
+	{
+		return;
+	}
+
+	for (FPooledEffect& Entry : Pool->Entries)
+	{
+		if (Entry.Component == Component)
+		{
+			if (Entry.bActive)
+			{
+				Entry.bActive = false;
+				Stats.Active--;
+				DEC_DWORD_STAT(STAT_EffectPoolActive);
+			}
+			break;
+		}
+	}
+}
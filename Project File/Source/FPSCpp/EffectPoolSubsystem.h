@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EffectPoolSubsystem.generated.h"
+
+class UParticleSystem;
+class UParticleSystemComponent;
+
+USTRUCT()
+struct FPooledEffect
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UParticleSystemComponent* Component = nullptr;
+
+	double StartTime = 0.0;
+
+	bool bActive = false;
+};
+
+USTRUCT()
+struct FEffectPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FPooledEffect> Entries;
+
+	int32 Budget = 0;
+};
+
+struct FEffectPoolStats
+{
+	int32 Active = 0;
+	int32 Pooled = 0;
+	int32 Created = 0;
+	int32 Recycled = 0;
+	int32 Stolen = 0;
+	int32 Culled = 0;
+};
+
+/**
+ * Recycles particle system components instead of spawning a new one per shot or explosion.
+ * Each template gets its own budget. When a pool is full the oldest running effect is stolen,
+ * and effects too far from every local viewer are not spawned at all.
+ */
+UCLASS(config=Game)
+class FPSCPP_API UEffectPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	UParticleSystemComponent* SpawnAtLocation(UParticleSystem* Template, const FVector& Location,
+	                                          const FRotator& Rotation = FRotator::ZeroRotator,
+	                                          const FVector& Scale = FVector(1.f));
+
+	UParticleSystemComponent* SpawnAttached(UParticleSystem* Template, USceneComponent* AttachToComponent,
+	                                        FName AttachPointName, const FVector& Location,
+	                                        const FRotator& Rotation, const FVector& Scale);
+
+	/** Creates components up front so the first shots of a match do not allocate */
+	void Prewarm(UParticleSystem* Template, int32 Count);
+
+	void SetBudget(UParticleSystem* Template, int32 Budget);
+
+	const FEffectPoolStats& GetStats() const { return Stats; }
+
+	/** Pool size for templates without an entry in TemplateBudgets */
+	UPROPERTY(config)
+	int32 DefaultBudget = 32;
+
+	UPROPERTY(config)
+	TMap<TSoftObjectPtr<UParticleSystem>, int32> TemplateBudgets;
+
+	/** Effects further than this from every local viewer are skipped, 0 disables culling */
+	UPROPERTY(config)
+	float CullDistance = 8000.f;
+
+private:
+	UParticleSystemComponent* Acquire(UParticleSystem* Template, const FVector& Location);
+
+	FEffectPool& FindOrAddPool(UParticleSystem* Template);
+
+	UParticleSystemComponent* CreateComponent(UParticleSystem* Template);
+
+	bool IsCulled(const FVector& Location) const;
+
+	UFUNCTION()
+	void OnEffectFinished(UParticleSystemComponent* Component);
+
+	UPROPERTY()
+	TMap<UParticleSystem*, FEffectPool> Pools;
+
+	FEffectPoolStats Stats;
+};
@@ -1,7 +1,24 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FPSCpp.h"
+#include "FPSCppMemory.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FPSCpp, "FPSCpp" );
- 
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogFPSCpp);
+
+UE_TRACE_CHANNEL_DEFINE(FPSCppChannel);
+
+TRACE_DECLARE_INT_COUNTER(FPSCppShotsPerSecond, TEXT("FPSCpp/Shots Per Second"));
+TRACE_DECLARE_INT_COUNTER(FPSCppHitsPerSecond, TEXT("FPSCpp/Hits Per Second"));
+TRACE_DECLARE_INT_COUNTER(FPSCppLiveGrenades, TEXT("FPSCpp/Live Grenades"));
+
+class FFPSCppModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FFPSCppMemory::RegisterTags();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FFPSCppModule, FPSCpp, "FPSCpp" );
@@ -3,3 +3,29 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+DECLARE_STATS_GROUP(TEXT("FPSCpp"), STATGROUP_FPSCpp, STATCAT_Advanced);
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFPSCpp, Log, All);
+
+/** Gameplay scopes and counters in Unreal Insights, enable with -trace=cpu,FPSCpp */
+UE_TRACE_CHANNEL_EXTERN(FPSCppChannel, FPSCPP_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(FPSCppShotsPerSecond);
+TRACE_DECLARE_INT_COUNTER_EXTERN(FPSCppHitsPerSecond);
+TRACE_DECLARE_INT_COUNTER_EXTERN(FPSCppLiveGrenades);
+
+// 统计和Insights共用一个作用域
+#define FPSCPP_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(#Stat, FPSCppChannel)
+
+// 每次事件都打的日志, shipping版本里不编译
+#if UE_BUILD_SHIPPING
+#define FPSCPP_EVENT_LOG(Format, ...)
+#else
+#define FPSCPP_EVENT_LOG(Format, ...) UE_LOG(LogFPSCpp, Verbose, Format, ##__VA_ARGS__)
+#endif
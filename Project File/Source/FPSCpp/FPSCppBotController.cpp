@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPSCppBotController.h"
+#include "FPSCppCharacter.h"
+#include "Components/InputComponent.h"
+
+AFPSCppBotController::AFPSCppBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bWantsPlayerState = true;
+	BotInput = nullptr;
+}
+
+void AFPSCppBotController::SetSeed(int32 Seed)
+{
+	Random.Initialize(Seed);
+}
+
+void AFPSCppBotController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	AFPSCppCharacter* BotCharacter = Cast<AFPSCppCharacter>(InPawn);
+	if (!BotCharacter)
+	{
+		return;
+	}
+
+	// 重生时pawn来自对象池, 每次占有都重新绑定
+	BotInput = NewObject<UInputComponent>(this, TEXT("BotInput"));
+	BotCharacter->SetupBotInput(BotInput);
+
+	NextMove = 0.f;
+	NextFire = Random.FRandRange(0.5f, 2.f);
+	FireRemaining = 0.f;
+	NextReload = Random.FRandRange(8.f, 15.f);
+	NextGrenade = Random.FRandRange(10.f, 25.f);
+	NextZoom = Random.FRandRange(3.f, 8.f);
+	NextCrouch = Random.FRandRange(4.f, 10.f);
+	bZooming = false;
+	bCrouching = false;
+}
+
+void AFPSCppBotController::OnUnPossess()
+{
+	BotInput = nullptr;
+	Super::OnUnPossess();
+}
+
+void AFPSCppBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (BotInput && GetPawn())
+	{
+		StepScript(DeltaSeconds);
+	}
+}
+
+void AFPSCppBotController::SendAction(FName ActionName, EInputEvent KeyEvent)
+{
+	for (int32 Index = 0; Index < BotInput->GetNumActionBindings(); ++Index)
+	{
+		FInputActionBinding& Binding = BotInput->GetActionBinding(Index);
+		if (Binding.KeyEvent == KeyEvent && Binding.GetActionName() == ActionName)
+		{
+			Binding.ActionDelegate.Execute(EKeys::Invalid);
+		}
+	}
+}
+
+void AFPSCppBotController::SendAxis(FName AxisName, float Value)
+{
+	for (FInputAxisBinding& Binding : BotInput->AxisBindings)
+	{
+		if (Binding.AxisName == AxisName)
+		{
+			Binding.AxisValue = Value;
+			Binding.AxisDelegate.Execute(Value);
+		}
+	}
+}
+
+void AFPSCppBotController::StepScript(float DeltaSeconds)
+{
+	// 移动方向和转向每隔几秒随机换一次
+	NextMove -= DeltaSeconds;
+	if (NextMove <= 0.f)
+	{
+		NextMove = Random.FRandRange(1.5f, 4.f);
+		ForwardAxis = Random.FRandRange(-1.f, 1.f);
+		RightAxis = Random.FRandRange(-1.f, 1.f);
+		YawRate = Random.FRandRange(-90.f, 90.f);
+	}
+	SendAxis(TEXT("MoveForward"), ForwardAxis);
+	SendAxis(TEXT("MoveRight"), RightAxis);
+
+	// AI控制器不处理AddControllerYawInput, 直接转控制旋转
+	SetControlRotation(GetControlRotation() + FRotator(0.f, YawRate * DeltaSeconds, 0.f));
+
+	if (FireRemaining > 0.f)
+	{
+		FireRemaining -= DeltaSeconds;
+		if (FireRemaining <= 0.f)
+		{
+			SendAction(TEXT("Fire"), IE_Released);
+		}
+	}
+	else
+	{
+		NextFire -= DeltaSeconds;
+		if (NextFire <= 0.f)
+		{
+			NextFire = Random.FRandRange(0.5f, 3.f);
+			FireRemaining = Random.FRandRange(0.2f, 1.5f);
+			SendAction(TEXT("Fire"), IE_Pressed);
+		}
+	}
+
+	NextReload -= DeltaSeconds;
+	if (NextReload <= 0.f)
+	{
+		NextReload = Random.FRandRange(8.f, 15.f);
+		SendAction(TEXT("Reload"), IE_Pressed);
+	}
+
+	NextGrenade -= DeltaSeconds;
+	if (NextGrenade <= 0.f)
+	{
+		NextGrenade = Random.FRandRange(10.f, 25.f);
+		SendAction(TEXT("Grenade"), IE_Pressed);
+	}
+
+	NextZoom -= DeltaSeconds;
+	if (NextZoom <= 0.f)
+	{
+		NextZoom = Random.FRandRange(3.f, 8.f);
+		bZooming = !bZooming;
+		SendAction(TEXT("ZoomIn"), bZooming ? IE_Pressed : IE_Released);
+	}
+
+	NextCrouch -= DeltaSeconds;
+	if (NextCrouch <= 0.f)
+	{
+		NextCrouch = Random.FRandRange(4.f, 10.f);
+		bCrouching = !bCrouching;
+		SendAction(TEXT("Crouch"), bCrouching ? IE_Pressed : IE_Released);
+	}
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "FPSCppBotController.generated.h"
+
+/**
+ * Server side load test bot. Possessed characters bind their normal player input to the bot's own
+ * input component, and a seeded script presses the same actions and axes a player would, so bots
+ * run exactly the gameplay code path of a real client's input.
+ */
+UCLASS()
+class FPSCPP_API AFPSCppBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AFPSCppBotController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Same seed, same sequence of inputs */
+	void SetSeed(int32 Seed);
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+private:
+	/** Runs every binding of the action for the key event, like a key press routed through the player input stack */
+	void SendAction(FName ActionName, EInputEvent KeyEvent);
+
+	void SendAxis(FName AxisName, float Value);
+
+	void StepScript(float DeltaSeconds);
+
+	UPROPERTY(Transient)
+	UInputComponent* BotInput;
+
+	FRandomStream Random;
+
+	float ForwardAxis = 0.f;
+	float RightAxis = 0.f;
+	float YawRate = 0.f;
+
+	// 距离下次动作的秒数
+	float NextMove = 0.f;
+	float NextFire = 0.f;
+	float FireRemaining = 0.f;
+	float NextReload = 0.f;
+	float NextGrenade = 0.f;
+	float NextZoom = 0.f;
+	float NextCrouch = 0.f;
+
+	bool bZooming = false;
+	bool bCrouching = false;
+};
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FPSCppCharacter.h"
+#include "FPSCpp.h"
 #include "FPSCppProjectile.h"
 #include "Target.h"
 #include "Grenade.h"
@@ -11,22 +12,44 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/InputSettings.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
+#include "ActorPoolSubsystem.h"
+#include "BulletSubsystem.h"
+#include "DamageReceiver.h"
+#include "DamageRegistrySubsystem.h"
+#include "EffectPoolSubsystem.h"
+#include "FireInputProcessor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "FPSCppCharacterMovement.h"
+#include "FPSCppMemory.h"
+#include "FPSCppGameMode.h"
+#include "GameplayEventSubsystem.h"
 #include "HealthComponent.h"
+#include "HitscanSubsystem.h"
+#include "LagCompensationSubsystem.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "ReplicationStats.h"
 #include "MotionControllerComponent.h"
 #include "XRMotionControllerBase.h" // for FXRMotionControllerBase::RightHandSourceId
 #include "Blueprint/UserWidget.h"
 #include "Components/SpotLightComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameStateBase.h"
 #include "GameFramework/PawnMovementComponent.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogFPChar, Warning, All);
 
+DECLARE_CYCLE_STAT(TEXT("Character Fire"), STAT_CharacterFire, STATGROUP_FPSCpp);
+DECLARE_CYCLE_STAT(TEXT("Character Reload"), STAT_CharacterReload, STATGROUP_FPSCpp);
+DECLARE_CYCLE_STAT(TEXT("Character Grenade"), STAT_CharacterGrenade, STATGROUP_FPSCpp);
+
 //////////////////////////////////////////////////////////////////////////
 // AFPSCppCharacter
 
-AFPSCppCharacter::AFPSCppCharacter()
+AFPSCppCharacter::AFPSCppCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UFPSCppCharacterMovement>(ACharacter::CharacterMovementComponentName))
 {
+	FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Characters);
 	GetCapsuleComponent()->InitCapsuleSize(55.f, 96.0f);
 	
 	BaseTurnRate = 45.f;
@@ -39,37 +62,24 @@ AFPSCppCharacter::AFPSCppCharacter()
 	Mesh1P->SetRelativeRotation(FRotator(0.f, -90.f, 0.f));
 	Mesh1P->SetRelativeLocation(FVector(-0.f, -0.f, -90.f));
 
-	Gun = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("GunMesh"));
-	Gun->SetupAttachment(Mesh1P, TEXT("Gun"));
-
-	TPSCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
-	CameraSpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraSpringArm"));
-	CameraSpringArm->SetupAttachment(Mesh1P);
-	TPSCameraComponent->SetupAttachment(CameraSpringArm);
-	TPSCameraComponent->AttachToComponent(CameraSpringArm, FAttachmentTransformRules::KeepRelativeTransform);
-	CameraSpringArm->bUsePawnControlRotation = true;
-	CameraSpringArm->bEnableCameraLag = true;
-	CameraSpringArm->TargetArmLength = 300.f;
-	CameraSpringArm->SetRelativeLocation(FVector(60.f, 0.f, 160.f));
-
-	ZoomCameraLocation = CreateDefaultSubobject<USceneComponent>(TEXT("ZoomCameraLocation"));
-	ZoomCameraLocation->SetupAttachment(Mesh1P, TEXT("head"));
-
-	ZoomInCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("ZoomInCamera"));
-	ZoomInCamera->SetupAttachment(ZoomCameraLocation);
-	ZoomInCamera->bUsePawnControlRotation = true;
-	ZoomInCamera->SetRelativeLocation(FVector(13.f, 5.f, -5.f));
-	ZoomInCamera->SetRelativeRotation(FRotator(-30.f, 75.f, -110.f));
+	{
+		FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Weapons);
+		Gun = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("GunMesh"));
+		Gun->SetupAttachment(Mesh1P, TEXT("Gun"));
+	}
 
-	MainCamera = TPSCameraComponent;
+	HealthComponent = CreateDefaultSubobject<UHealthComponent>(TEXT("HealthComponent"));
+	//死亡后保留尸体, 由复活流程放回对象池
+	HealthComponent->bReleaseOwnerOnDeath = false;
 
-	MuzzleLocation = CreateDefaultSubobject<USceneComponent>(TEXT("MuzzleLocation"));
-	MuzzleLocation->SetupAttachment(Gun);
-	MuzzleLocation->SetRelativeLocation(FVector(0.f, 50.f, 0.f));
+	// 和BP_Character里原来的组件设置一致
+	MuzzleOffset = FVector(0.f, 50.f, 10.f);
+	MuzzleRotation = FRotator(0.f, 90.f, 0.f);
+	GrenadeOffset = FVector(-20.f, 10.f, 0.f);
 
-	GrenadeLocation = CreateDefaultSubobject<USceneComponent>(TEXT("GrenadeLocation"));
-	GrenadeLocation->SetupAttachment(Gun);
-	GrenadeLocation->SetRelativeLocation(FVector(10.f, 30.f, 10.f));
+	CameraArmLength = 200.f;
+	CameraArmTransform = FTransform(FRotator(0.f, -10.f, 0.f), FVector(-34.7f, 5.8f, 187.f));
+	TPSCameraOffset = FVector(5.4f, -0.5f, 0.f);
 	
 	GunOffset = FVector(100.0f, 0.0f, 10.0f);
 
@@ -86,17 +96,159 @@ AFPSCppCharacter::AFPSCppCharacter()
 	bAbleToCrouch = true;
 	bAbleToRun=true;
 	bAbleToUseGrenade=true;
+	bFireProjectiles = false;
+	bIsFiring = false;
+	bIsReloading = false;
+	bIsCrouching = false;
+	bIsZooming = false;
+	bIsJumping = false;
+	bIsRunning = false;
+	bIsDead = false;
+	FireMode = EFireMode::FullAuto;
+	FireRate = 900.f;
+	BurstCount = 3;
 	HitImpulse = 100000.0f;
 	ShootingDistance=10000.0f;
+	RespawnDelay = 5.f;
+	MaxShotsPerBatch = 16;
+	MaxShotOriginError = 200.f;
 }
 
 void AFPSCppCharacter::BeginPlay()
 {
 	// Call the base class  
 	Super::BeginPlay();
-	if (PlayerStateWidget)
+	FireScheduler.SetRoundsPerMinute(FireRate);
+	MeshRelativeTransform = GetMesh()->GetRelativeTransform();
+	MeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+	HealthComponent->OnDied.AddDynamic(this, &AFPSCppCharacter::OnDied);
+	if (UEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UEffectPoolSubsystem>())
+	{
+		EffectPool->Prewarm(ShootParticle, 4);
+		EffectPool->Prewarm(HittedParticle, 16);
+	}
+	if (HasAuthority())
 	{
-		CreateWidget<UUserWidget>(GetWorld(), PlayerStateWidget)->AddToViewport();
+		if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		{
+			LagCompensation->Register(this);
+		}
+	}
+	NotifyAmmoChanged();
+}
+
+void AFPSCppCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFireInput();
+	if (PlayerStateWidgetInstance)
+	{
+		PlayerStateWidgetInstance->RemoveFromParent();
+		PlayerStateWidgetInstance = nullptr;
+	}
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->Unregister(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+UFPSCppCharacterMovement* AFPSCppCharacter::GetFPSCppMovement() const
+{
+	return CastChecked<UFPSCppCharacterMovement>(GetCharacterMovement());
+}
+
+void AFPSCppCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams OwnerOnlyParams;
+	OwnerOnlyParams.bIsPushBased = true;
+	OwnerOnlyParams.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, CurrentAmmo, OwnerOnlyParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, FullAmmo, OwnerOnlyParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, GrenadeCount, OwnerOnlyParams);
+
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, bIsFiring, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, bIsReloading, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, bIsCrouching, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, bIsZooming, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, bIsRunning, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AFPSCppCharacter, bIsDead, SharedParams);
+}
+
+void AFPSCppCharacter::SetIsFiring(bool bNewIsFiring)
+{
+	if (bIsFiring != bNewIsFiring)
+	{
+		bIsFiring = bNewIsFiring;
+		FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, bIsFiring, this);
+	}
+}
+
+void AFPSCppCharacter::SetIsReloading(bool bNewIsReloading)
+{
+	if (bIsReloading != bNewIsReloading)
+	{
+		bIsReloading = bNewIsReloading;
+		FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, bIsReloading, this);
+	}
+}
+
+void AFPSCppCharacter::SetIsCrouching(bool bNewIsCrouching)
+{
+	if (bIsCrouching != bNewIsCrouching)
+	{
+		bIsCrouching = bNewIsCrouching;
+		FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, bIsCrouching, this);
+	}
+}
+
+void AFPSCppCharacter::SetIsZooming(bool bNewIsZooming)
+{
+	if (bIsZooming != bNewIsZooming)
+	{
+		bIsZooming = bNewIsZooming;
+		FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, bIsZooming, this);
+	}
+}
+
+void AFPSCppCharacter::SetIsRunning(bool bNewIsRunning)
+{
+	if (bIsRunning != bNewIsRunning)
+	{
+		bIsRunning = bNewIsRunning;
+		FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, bIsRunning, this);
+	}
+}
+
+void AFPSCppCharacter::SetIsDead(bool bNewIsDead)
+{
+	if (bIsDead != bNewIsDead)
+	{
+		bIsDead = bNewIsDead;
+		FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, bIsDead, this);
+	}
+}
+
+void AFPSCppCharacter::OnRep_Ammo()
+{
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->Post(FAmmoChangedEvent{this, CurrentAmmo, FullAmmo, GrenadeCount});
+	}
+}
+
+void AFPSCppCharacter::NotifyAmmoChanged()
+{
+	FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, CurrentAmmo, this);
+	FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, FullAmmo, this);
+	FPSCPP_MARK_PROPERTY_DIRTY(AFPSCppCharacter, GrenadeCount, this);
+
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->Post(FAmmoChangedEvent{this, CurrentAmmo, FullAmmo, GrenadeCount});
 	}
 }
 
@@ -109,8 +261,9 @@ void AFPSCppCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerIn
 	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
 	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
 	
-	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &AFPSCppCharacter::OnFire);
+	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &AFPSCppCharacter::StartFire);
 	PlayerInputComponent->BindAction("Fire", IE_Released, this, &AFPSCppCharacter::StopFire);
+	PlayerInputComponent->BindAction("SwitchFireMode", IE_Pressed, this, &AFPSCppCharacter::CycleFireMode);
 
 	PlayerInputComponent->BindAction("Reload", IE_Pressed, this, &AFPSCppCharacter::Reload);
 
@@ -140,7 +293,8 @@ void AFPSCppCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerIn
 
 void AFPSCppCharacter::OnFire()
 {
-	if (!bAbleToFire)
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_CharacterFire);
+	if (!bAbleToFire || bIsDead)
 		return;
 	if (GetCharacterMovement()->Velocity.Size() <= 300)
 	{
@@ -195,12 +349,185 @@ void AFPSCppCharacter::OnFire()
 	FVector HitLocationOffset = 0.02 * FVector(FMath::RandRange(-AimOffSet, AimOffSet),
 	                                           FMath::RandRange(-AimOffSet, AimOffSet),
 	                                           FMath::RandRange(-AimOffSet, AimOffSet));
-	FHitResult HitResult;
-	FVector Start = MainCamera->GetComponentLocation();
-	FVector End = MainCamera->GetComponentLocation() + (MainCamera->GetForwardVector() + HitLocationOffset).
-		GetSafeNormal() * ShootingDistance;
 
-	GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECollisionChannel::ECC_Visibility);
+	// 按下开火那一刻的瞄准, 而不是这一帧处理到开火时的相机姿态
+	const double Now = FPlatformTime::Seconds();
+	const double InputTime = PendingFireInputTime;
+	PendingFireInputTime = 0.0;
+	FVector Start;
+	FQuat AimRotation;
+	if (InputTime > 0.0)
+	{
+		Start = PendingFireAimLocation;
+		AimRotation = PendingFireAimRotation;
+	}
+	else
+	{
+		GetAim(Start, AimRotation);
+	}
+	FVector Direction = (AimRotation.GetForwardVector() + HitLocationOffset).GetSafeNormal();
+	FVector End = Start + Direction * ShootingDistance;
+
+	const uint8 ShotId = NextShotId++;
+	ShotInputTimes[ShotId] = InputTime;
+	if (InputTime > 0.0)
+	{
+		FFireLatencyStats::RecordShot(InputTime);
+	}
+
+	// 客户端只做表现, 射击攒起来按网络更新批量发给服务器结算
+	if (HasAuthority())
+	{
+		FireShot(Start, Direction, -1.f, ShotId);
+	}
+	else
+	{
+		FFiredShot& Shot = PendingShots.AddDefaulted_GetRef();
+		Shot.Origin = Start;
+		Shot.Direction = Direction;
+		Shot.ShotId = ShotId;
+		if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+		{
+			const double InputAge = InputTime > 0.0 ? Now - InputTime : 0.0;
+			Shot.ClientTime = GameState->GetServerWorldTimeSeconds() - InputAge;
+		}
+	}
+
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->Post(FShotFiredEvent{this, Start, End});
+	}
+
+	if (FireSound != nullptr)
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+	}
+
+	if (ShootParticle)
+	{
+		if (UEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UEffectPoolSubsystem>())
+		{
+			EffectPool->SpawnAttached(ShootParticle, Gun, NAME_None, MuzzleOffset,
+			                          MuzzleRotation, FVector(.1f));
+		}
+	}
+
+	if (APlayerController* PlayerController = Cast<APlayerController>(GetController()))
+	{
+		PlayerController->ClientStartCameraShake(CameraShake);
+	}
+
+	CurrentAmmo -= 1;
+	NotifyAmmoChanged();
+
+	if (CurrentAmmo == 0)
+	{
+		Reload();
+	}
+}
+
+void AFPSCppCharacter::FireShot(const FVector& Start, const FVector& Direction, float ClientTime, uint8 ShotId)
+{
+	const FVector End = Start + Direction * ShootingDistance;
+
+	if (bFireProjectiles && ProjectileClass != nullptr)
+	{
+		// 子弹从枪口飞向准星所指的位置
+		if (UBulletSubsystem* Bullets = GetWorld()->GetSubsystem<UBulletSubsystem>())
+		{
+			const FVector MuzzlePosition = GetMuzzleLocation();
+			Bullets->FireBullet(ProjectileClass, MuzzlePosition, End - MuzzlePosition, this);
+		}
+	}
+	else if (UHitscanSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanSubsystem>())
+	{
+		Hitscan->QueueShot(this, Start, End, ClientTime, ShotId);
+	}
+}
+
+void AFPSCppCharacter::ServerFireShots_Implementation(const TArray<FFiredShot>& Shots)
+{
+	// 按客户端开枪的时间戳发放可开的枪数, RPC到达的抖动不会丢掉合法的射击
+	// 时间戳不能早于上一发也不能晚于服务器当前时间, 最多攒一秒的射速
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float Now = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	const float ShotsPerSecond = FMath::Max(FireRate, 1.f) / 60.f;
+	const float MaxBudget = FMath::Max(ShotsPerSecond, 1.f);
+
+	const FVector ViewLocation = GetPawnViewLocation();
+	int32 NumAccepted = 0;
+	for (const FFiredShot& Shot : Shots)
+	{
+		if (NumAccepted >= MaxShotsPerBatch || CurrentAmmo <= 0 || !bAbleToFire || bIsReloading || bIsDead)
+		{
+			break;
+		}
+		const float ShotTime = FMath::Clamp(Shot.ClientTime > 0.f ? Shot.ClientTime : Now, LastServerShotTime, Now);
+		ServerShotBudget = FMath::Min(ServerShotBudget + (ShotTime - LastServerShotTime) * ShotsPerSecond, MaxBudget);
+		LastServerShotTime = ShotTime;
+		if (ServerShotBudget < 1.f)
+		{
+			continue;
+		}
+		const FVector Direction = FVector(Shot.Direction).GetSafeNormal();
+		if (Direction.IsZero() || FVector::DistSquared(Shot.Origin, ViewLocation) > FMath::Square(MaxShotOriginError))
+		{
+			continue;
+		}
+		ServerShotBudget -= 1.f;
+		NumAccepted++;
+		FireShot(Shot.Origin, Direction, Shot.ClientTime, Shot.ShotId);
+		CurrentAmmo -= 1;
+	}
+	NotifyAmmoChanged();
+
+	if (CurrentAmmo <= 0)
+	{
+		Reload();
+	}
+}
+
+void AFPSCppCharacter::MulticastConfirmHits_Implementation(const TArray<FConfirmedHit>& Hits)
+{
+	UEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UEffectPoolSubsystem>();
+	if (!EffectPool)
+	{
+		return;
+	}
+	for (const FConfirmedHit& Hit : Hits)
+	{
+		EffectPool->SpawnAtLocation(HittedParticle, Hit.ImpactPoint, FRotator::ZeroRotator, FVector(.2f));
+
+		if (IsLocallyControlled() && ShotInputTimes[Hit.ShotId] > 0.0)
+		{
+			FFireLatencyStats::RecordImpact(ShotInputTimes[Hit.ShotId]);
+			ShotInputTimes[Hit.ShotId] = 0.0;
+		}
+	}
+}
+
+void AFPSCppCharacter::FlushShots()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// 每个网络更新间隔最多一次RPC, 连发多少发都合并在一起
+	if (PendingShots.Num() > 0 && Now - LastShotBatchTime >= 1.f / FMath::Max(NetUpdateFrequency, 1.f))
+	{
+		ServerFireShots(PendingShots);
+		PendingShots.Reset();
+		LastShotBatchTime = Now;
+	}
+
+	if (PendingHits.Num() > 0)
+	{
+		MulticastConfirmHits(PendingHits);
+		PendingHits.Reset();
+	}
+}
+
+void AFPSCppCharacter::ResolveShot(const FHitResult& HitResult, const FVector& Start, const FVector& End,
+                                   uint8 ShotId)
+{
 	if (HitResult.GetComponent())
 	{
 		AActor* HittedActor=HitResult.GetActor();
@@ -210,66 +537,77 @@ void AFPSCppCharacter::OnFire()
 		{
 			float PointImpulse;
 			PointImpulse = HitImpulse * (ShootingDistance - (HitResult.ImpactPoint - GetActorLocation()).Size()) / ShootingDistance;
-			UE_LOG(LogTemp, Error, TEXT("%f"), PointImpulse);
+			FPSCPP_EVENT_LOG(TEXT("PointImpulse %f"), PointImpulse);
 			HittedComponent->AddImpulseAtLocation((End - Start).GetSafeNormal() * PointImpulse,
 			                                               GetActorLocation());
 		}
 
-		if (HittedActor->IsA<ATarget>())
+		//靶子与生命组件统一走伤害注册表
+		UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>();
+		IDamageReceiver* Receiver = Registry ? Registry->FindReceiver(HittedActor) : nullptr;
+		if (Receiver)
 		{
-			Cast<ATarget>(HittedActor)->Hitted();
-		}
+			const float Damage = HitResult.BoneName == "head" ? 50.f : 10.f;
+			Receiver->ReceiveDamage(Damage, HitResult, this);
 
-		//存在生命组件
-		TSubclassOf<class UHealthComponent> HealthClass=UHealthComponent::StaticClass();
-		UActorComponent* GettedComponent;
-		GettedComponent=HittedActor->GetComponentByClass(HealthClass);
-		
-		if(GettedComponent)
-		{
-			UHealthComponent* HealthComponent=Cast<UHealthComponent>(GettedComponent);
-			if(HitResult.BoneName=="head")
-			{
-				HealthComponent->ChangeHealth(50.f);
-			}
-			else
+			if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
 			{
-				HealthComponent->ChangeHealth(10.f);
+				Events->Post(FDamageAppliedEvent{HittedActor, this, Damage});
 			}
-			
 		}
 
 		
 
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), HittedParticle, HitResult.ImpactPoint,
-		                                         FRotator::ZeroRotator, FVector(.2f));
+		FConfirmedHit& ConfirmedHit = PendingHits.AddDefaulted_GetRef();
+		ConfirmedHit.ImpactPoint = HitResult.ImpactPoint;
+		ConfirmedHit.ShotId = ShotId;
 	}
+}
 
-
-	if (FireSound != nullptr)
+void AFPSCppCharacter::StartFire()
+{
+	if (bIsDead)
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+		PendingFireInputTime = 0.0;
+		return;
 	}
-
-	if (ShootParticle)
+	SetIsFiring(true);
+	FireScheduler.SetRoundsPerMinute(FireRate);
+	FireScheduler.Press(FireMode, BurstCount);
+
+	// 按下的这一帧立即开第一枪
+	const int32 Shots = FireScheduler.Advance(0.f);
+	FireStartFrame = GFrameCounter;
+	for (int32 Shot = 0; Shot < Shots; ++Shot)
 	{
-		UGameplayStatics::SpawnEmitterAttached(ShootParticle, MuzzleLocation, "Mozzle", FVector(0.f),
-		                                       FRotator::ZeroRotator, FVector(.1f));
+		OnFire();
 	}
+	// 换弹, 奔跑时按下没开出去的时间戳也要清掉, 不能留给之后的射击
+	PendingFireInputTime = 0.0;
 
-	GetWorld()->GetFirstPlayerController()->ClientStartCameraShake(CameraShake);
-
-	CurrentAmmo -= 1;
-
-	if (CurrentAmmo == 0)
-	{
-		Reload();
-	}
+	FlushShots();
 }
 
 void AFPSCppCharacter::StopFire()
 {
-	bIsFiring = false;
+	SetIsFiring(false);
+	FireScheduler.Release();
+}
+
+void AFPSCppCharacter::CycleFireMode()
+{
+	switch (FireMode)
+	{
+	case EFireMode::Semi:
+		FireMode = EFireMode::Burst;
+		break;
+	case EFireMode::Burst:
+		FireMode = EFireMode::FullAuto;
+		break;
+	case EFireMode::FullAuto:
+		FireMode = EFireMode::Semi;
+		break;
+	}
 }
 
 
@@ -304,12 +642,147 @@ void AFPSCppCharacter::LookUpAtRate(float Rate)
 void AFPSCppCharacter::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
+
+	// 一帧可能跨过多个射击间隔, 每一发都要打出去
+	// 按下的那一帧已经开过第一枪, 这一帧的时间发生在按下之前, 不计入间隔
+	const int32 Shots = FireScheduler.Advance(FireStartFrame == GFrameCounter ? 0.f : DeltaSeconds);
+	for (int32 Shot = 0; Shot < Shots; ++Shot)
+	{
+		if (!bAbleToFire)
+		{
+			if (FireMode != EFireMode::FullAuto)
+			{
+				FireScheduler.Stop();
+			}
+			break;
+		}
+		OnFire();
+	}
+
+	// 连发的后续射击也要按网络更新间隔发给服务器, 不能等到下一次按下
+	FlushShots();
+}
+
+void AFPSCppCharacter::NotifyFireInput(double InputTime)
+{
+	if (!bIsDead)
+	{
+		// Slate处理输入时这一帧的相机还没更新, 就是玩家按下时看到的画面
+		PendingFireInputTime = InputTime;
+		GetAim(PendingFireAimLocation, PendingFireAimRotation);
+	}
+}
+
+void AFPSCppCharacter::GetAim(FVector& OutLocation, FQuat& OutRotation) const
+{
+	// 服务器上的机器人没有相机, 用控制器的视角
+	if (!MainCamera)
+	{
+		FRotator EyesRotation;
+		GetActorEyesViewPoint(OutLocation, EyesRotation);
+		OutRotation = EyesRotation.Quaternion();
+		return;
+	}
+	OutLocation = MainCamera->GetComponentLocation();
+	OutRotation = MainCamera->GetComponentQuat();
+}
+
+void AFPSCppCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	CreateCameraComponents();
+
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (PlayerStateWidget && PlayerController && PlayerController->IsLocalController())
+	{
+		if (!PlayerStateWidgetInstance)
+		{
+			PlayerStateWidgetInstance = CreateWidget<UUserWidget>(PlayerController, PlayerStateWidget);
+		}
+		if (PlayerStateWidgetInstance && !PlayerStateWidgetInstance->IsInViewport())
+		{
+			PlayerStateWidgetInstance->AddToViewport();
+		}
+	}
+
+	if (!FireInputProcessor.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FireInputProcessor = MakeShared<FFireInputProcessor>(this);
+		FSlateApplication::Get().RegisterInputPreProcessor(FireInputProcessor);
+	}
+}
+
+void AFPSCppCharacter::CreateCameraComponents()
+{
+	if (MainCamera)
+	{
+		return;
+	}
+	FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Characters);
+
+	CameraSpringArm = NewObject<USpringArmComponent>(this, TEXT("CameraSpringArm"));
+	CameraSpringArm->SetupAttachment(Mesh1P);
+	CameraSpringArm->bUsePawnControlRotation = true;
+	CameraSpringArm->bEnableCameraLag = true;
+	CameraSpringArm->TargetArmLength = CameraArmLength;
+	CameraSpringArm->SetRelativeTransform(CameraArmTransform);
+	if (bIsCrouching)
+	{
+		CameraSpringArm->AddLocalOffset(FVector(0.f, 0.f, -40.f));
+	}
+
+	TPSCameraComponent = NewObject<UCameraComponent>(this, TEXT("FirstPersonCamera"));
+	TPSCameraComponent->SetupAttachment(CameraSpringArm);
+	TPSCameraComponent->SetRelativeLocation(TPSCameraOffset);
+
+	ZoomCameraLocation = NewObject<USceneComponent>(this, TEXT("ZoomCameraLocation"));
+	ZoomCameraLocation->SetupAttachment(Mesh1P, TEXT("head"));
+
+	ZoomInCamera = NewObject<UCameraComponent>(this, TEXT("ZoomInCamera"));
+	ZoomInCamera->SetupAttachment(ZoomCameraLocation);
+	ZoomInCamera->bUsePawnControlRotation = true;
+	ZoomInCamera->bAutoActivate = false;
+	ZoomInCamera->SetRelativeLocation(FVector(13.f, 5.f, -5.f));
+	ZoomInCamera->SetRelativeRotation(FRotator(-30.f, 75.f, -110.f));
+
+	CameraSpringArm->RegisterComponent();
+	TPSCameraComponent->RegisterComponent();
+	ZoomCameraLocation->RegisterComponent();
+	ZoomInCamera->RegisterComponent();
+
+	MainCamera = TPSCameraComponent;
+}
+
+void AFPSCppCharacter::SetupBotInput(UInputComponent* BotInputComponent)
+{
+	SetupPlayerInputComponent(BotInputComponent);
+}
+
+void AFPSCppCharacter::UnregisterFireInput()
+{
+	if (FireInputProcessor.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().UnregisterInputPreProcessor(FireInputProcessor);
+	}
+	FireInputProcessor.Reset();
+	PendingFireInputTime = 0.0;
 }
 
 
 /*换弹*/
+void AFPSCppCharacter::ServerReload_Implementation()
+{
+	Reload();
+}
+
 void AFPSCppCharacter::Reload()
 {
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_CharacterReload);
+	if (!HasAuthority())
+	{
+		ServerReload();
+	}
 	if (FullAmmo == 0)
 	{
 		bAbleToFire = false;
@@ -322,10 +795,12 @@ void AFPSCppCharacter::Reload()
 		}
 
 		bAbleToFire = false;
-		bIsReloading = true;
-
-		GetCharacterMovement()->MaxWalkSpeed = 270;
-		GetWorldTimerManager().SetTimer(ReloadTimerHandle, this, &AFPSCppCharacter::ReloadFinish, 2.f, false);
+		SetIsReloading(true);
+		GetFPSCppMovement()->SetModifier(EMovementModifier::Reload, true);
+		if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+		{
+			ReloadTimerHandle = Timers->SetTimer(this, &AFPSCppCharacter::ReloadFinish, ReloadTime);
+		}
 
 		if (CurrentAmmo + FullAmmo < PerAmmo)
 		{
@@ -337,53 +812,74 @@ void AFPSCppCharacter::Reload()
 			FullAmmo = FullAmmo - PerAmmo + CurrentAmmo;
 			CurrentAmmo = PerAmmo;
 		}
+		NotifyAmmoChanged();
 	}
 }
 
 void AFPSCppCharacter::ReloadFinish()
 {
-	if (!bIsCrouching&&!bIsZooming)
-	{
-		GetCharacterMovement()->MaxWalkSpeed = 600;
-	}
+	GetFPSCppMovement()->SetModifier(EMovementModifier::Reload, false);
 	bAbleToFire = true;
-	bIsReloading = false;
+	SetIsReloading(false);
 }
 
 /*手雷*/
 void AFPSCppCharacter::Grenade()
 {
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_CharacterGrenade);
 	if (!bAbleToUseGrenade||GrenadeCount == 0)
 	{
 		return;
 	}
+	// 客户端不预测手雷, 只把投掷方向交给服务器
+	if (!HasAuthority())
+	{
+		ServerGrenade(GetControlRotation());
+		return;
+	}
+	ThrowGrenade(GetControlRotation());
+}
+
+void AFPSCppCharacter::ServerGrenade_Implementation(FRotator ThrowRotation)
+{
+	if (!bAbleToUseGrenade || GrenadeCount == 0 || bIsDead)
+	{
+		return;
+	}
+	ThrowGrenade(ThrowRotation);
+}
+
+void AFPSCppCharacter::ThrowGrenade(const FRotator& ThrowRotation)
+{
 	if (GrenadeClass != nullptr)
 	{
 		UWorld* const World = GetWorld();
 		if (World != nullptr)
 		{
-			const FRotator SpawnRotation = GetControlRotation();
-			const FVector SpawnLocation = GrenadeLocation->GetComponentLocation();
+			const FRotator SpawnRotation = ThrowRotation;
+			const FVector SpawnLocation = GetGrenadeLocation();
 			
 			FActorSpawnParameters ActorSpawnParams;
 			ActorSpawnParams.SpawnCollisionHandlingOverride =
 				ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
 
-			AGrenade* Grenade = World->SpawnActor<AGrenade>(GrenadeClass, SpawnLocation, SpawnRotation,
-			                                                ActorSpawnParams);
+			UActorPoolSubsystem* ActorPool = World->GetSubsystem<UActorPoolSubsystem>();
+			AGrenade* Grenade = ActorPool
+				                    ? ActorPool->Acquire<AGrenade>(GrenadeClass, FTransform(SpawnRotation, SpawnLocation),
+				                                                   ActorSpawnParams)
+				                    : World->SpawnActor<AGrenade>(GrenadeClass, SpawnLocation, SpawnRotation,
+				                                                  ActorSpawnParams);
 			if (Grenade)
 			{
-				FVector2D ViewportSize;
-				FVector ScreenToWorldLoc;
-				FVector ScreenToWorldDir;
-				GetWorld()->GetGameViewport()->GetViewportSize(ViewportSize);
-				GetWorld()->GetFirstPlayerController()->DeprojectScreenPositionToWorld(
-					ViewportSize.X / 2, ViewportSize.Y / 2, ScreenToWorldLoc, ScreenToWorldDir);
-				Grenade->GetSphereComponent()->AddImpulse(ScreenToWorldDir * 30000);
+				Grenade->GetSphereComponent()->AddImpulse(ThrowRotation.Vector() * 30000);
 				
 				GrenadeCount--;
+				NotifyAmmoChanged();
 				bAbleToUseGrenade=false;
-				GetWorldTimerManager().SetTimer(GrenadeCoolDownTimerHandle,this,&AFPSCppCharacter::GrenadeCoolDown,5.f,false);
+				if (UGameplayTimerSubsystem* Timers = World->GetSubsystem<UGameplayTimerSubsystem>())
+				{
+					GrenadeCoolDownTimerHandle = Timers->SetTimer(this,&AFPSCppCharacter::GrenadeCoolDown,5.f);
+				}
 			}
 		}
 	}
@@ -397,12 +893,12 @@ void AFPSCppCharacter::GrenadeCoolDown()
 /*静步*/
 void AFPSCppCharacter::Walk()
 {
-	GetCharacterMovement()->MaxWalkSpeed = 270;
+	GetFPSCppMovement()->SetModifier(EMovementModifier::Walk, true);
 }
 
 void AFPSCppCharacter::StopWalk()
 {
-	GetCharacterMovement()->MaxWalkSpeed = 600;
+	GetFPSCppMovement()->SetModifier(EMovementModifier::Walk, false);
 }
 
 /*蹲*/
@@ -410,46 +906,53 @@ void AFPSCppCharacter::OnCrouch()
 {
 	if (bAbleToCrouch)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = 270;
-		CameraSpringArm->AddLocalOffset(FVector(0.f, 0.f, -40.f));
-		bIsCrouching = true;
+		GetFPSCppMovement()->SetCrouchModifier(true);
+		if (CameraSpringArm)
+		{
+			CameraSpringArm->AddLocalOffset(FVector(0.f, 0.f, -40.f));
+		}
+		SetIsCrouching(true);
 	}
 }
 
 void AFPSCppCharacter::StopCrouch()
 {
-	if (!bIsZooming)
+	GetFPSCppMovement()->SetCrouchModifier(false);
+	if (CameraSpringArm)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = 600;
+		CameraSpringArm->AddLocalOffset(FVector(0.f, 0.f, 40.f));
 	}
-	CameraSpringArm->AddLocalOffset(FVector(0.f, 0.f, 40.f));
-	bIsCrouching = false;
+	SetIsCrouching(false);
 }
 
 /*ADS*/
 void AFPSCppCharacter::OnZoom()
 {
-	if (bAbleToZoomIn && ZoomInCamera != nullptr)
+	if (bAbleToZoomIn)
 	{
-		MainCamera = ZoomInCamera;
-		bIsZooming = true;
-		GetCharacterMovement()->MaxWalkSpeed = 270;
-		ZoomInCamera->Activate();
-		TPSCameraComponent->Deactivate();
+		SetIsZooming(true);
+		GetFPSCppMovement()->SetModifier(EMovementModifier::ADS, true);
+		if (ZoomInCamera)
+		{
+			MainCamera = ZoomInCamera;
+			ZoomInCamera->Activate();
+			TPSCameraComponent->Deactivate();
+		}
 	}
 }
 
 void AFPSCppCharacter::StopZoom()
 {
-	if (bAbleToZoomIn && TPSCameraComponent != nullptr)
+	if (bAbleToZoomIn)
 	{
-		MainCamera = TPSCameraComponent;
-		bIsZooming = false;
-		if(!bIsReloading)
+		SetIsZooming(false);
+		GetFPSCppMovement()->SetModifier(EMovementModifier::ADS, false);
+		if (TPSCameraComponent)
 		{
-			GetCharacterMovement()->MaxWalkSpeed = 600;
+			MainCamera = TPSCameraComponent;
+			TPSCameraComponent->Activate();
+			ZoomInCamera->Deactivate();
 		}
-		TPSCameraComponent->Activate();
 	}
 }
 
@@ -460,8 +963,8 @@ void AFPSCppCharacter::Run()
 	{
 		bAbleToCrouch = false;
 		bAbleToFire = false;
-		bIsRunning = true;
-		GetCharacterMovement()->MaxWalkSpeed = 900;
+		SetIsRunning(true);
+		GetFPSCppMovement()->SetModifier(EMovementModifier::Sprint, true);
 	}
 }
 
@@ -469,8 +972,8 @@ void AFPSCppCharacter::StopRun()
 {
 	bAbleToCrouch = true;
 	bAbleToFire = true;
-	bIsRunning = false;
-	GetCharacterMovement()->MaxWalkSpeed = 600;
+	SetIsRunning(false);
+	GetFPSCppMovement()->SetModifier(EMovementModifier::Sprint, false);
 }
 
 //准星偏移
@@ -479,8 +982,126 @@ float AFPSCppCharacter::FireOffset()
 	return GetVelocity().Size() / 300.f;
 }
 
+FVector AFPSCppCharacter::GetMuzzleLocation() const
+{
+	return Gun->GetComponentTransform().TransformPosition(MuzzleOffset);
+}
+
+FVector AFPSCppCharacter::GetGrenadeLocation() const
+{
+	return Gun->GetComponentTransform().TransformPosition(GrenadeOffset);
+}
+
 float AFPSCppCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator,
 	AActor* DamageCauser)
 {
 	return Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
 }
+
+/*死亡与复活*/
+void AFPSCppCharacter::OnDied(AActor* DamageCauser)
+{
+	if (bIsDead)
+	{
+		return;
+	}
+	SetIsDead(true);
+
+	StopFire();
+	FireScheduler.Stop();
+	DisableInput(nullptr);
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>();
+
+	// 先播受击动画, 结束后再交给布娃娃
+	const float MontageLength = DeathMontage ? PlayAnimMontage(DeathMontage) : 0.f;
+	if (MontageLength > 0.f && Timers)
+	{
+		RagdollTimerHandle = Timers->SetTimer(this, &AFPSCppCharacter::StartRagdoll, MontageLength);
+	}
+	else
+	{
+		StartRagdoll();
+	}
+
+	if (Timers)
+	{
+		RespawnTimerHandle = Timers->SetTimer(this, &AFPSCppCharacter::RequestRespawn, RespawnDelay);
+	}
+}
+
+void AFPSCppCharacter::StartRagdoll()
+{
+	GetMesh()->SetCollisionProfileName(TEXT("Ragdoll"));
+	GetMesh()->SetSimulatePhysics(true);
+}
+
+void AFPSCppCharacter::RequestRespawn()
+{
+	AFPSCppGameMode* GameMode = GetWorld()->GetAuthGameMode<AFPSCppGameMode>();
+	if (GameMode && GetController())
+	{
+		GameMode->RespawnPlayer(GetController());
+	}
+}
+
+void AFPSCppCharacter::ClearTimers()
+{
+	if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+	{
+		Timers->ClearTimer(ReloadTimerHandle);
+		Timers->ClearTimer(GrenadeCoolDownTimerHandle);
+		Timers->ClearTimer(RagdollTimerHandle);
+		Timers->ClearTimer(RespawnTimerHandle);
+	}
+}
+
+void AFPSCppCharacter::OnPooledActivate()
+{
+	// 复用的pawn不会再走BeginPlay, 这里恢复到刚生成时的状态
+	const AFPSCppCharacter* Defaults = GetClass()->GetDefaultObject<AFPSCppCharacter>();
+	CurrentAmmo = Defaults->CurrentAmmo;
+	FullAmmo = Defaults->FullAmmo;
+	GrenadeCount = Defaults->GrenadeCount;
+	bAbleToFire = Defaults->bAbleToFire;
+	bAbleToUseGrenade = Defaults->bAbleToUseGrenade;
+	SetIsReloading(false);
+	SetIsFiring(false);
+	SetIsDead(false);
+	GetFPSCppMovement()->ClearModifiers();
+
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	GetMesh()->SetRelativeTransform(MeshRelativeTransform);
+	GetMesh()->SetCollisionProfileName(MeshCollisionProfile);
+	StopAnimMontage();
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	EnableInput(nullptr);
+
+	HealthComponent->Revive();
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->ResetHistory(this);
+	}
+	NotifyAmmoChanged();
+}
+
+void AFPSCppCharacter::OnPooledDeactivate()
+{
+	UnregisterFireInput();
+	ClearTimers();
+	FireScheduler.Stop();
+	GetMesh()->SetSimulatePhysics(false);
+	GetCharacterMovement()->DisableMovement();
+	SetActorTickEnabled(false);
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
@@ -3,9 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "FireScheduler.h"
 #include "FPSCppProjectile.h"
+#include "GameplayTimerSubsystem.h"
 #include "Grenade.h"
+#include "PooledActor.h"
 #include "Components/SpotLightComponent.h"
+#include "Engine/NetSerialization.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "FPSCppCharacter.generated.h"
@@ -17,9 +21,46 @@ class UCameraComponent;
 class UMotionControllerComponent;
 class UAnimMontage;
 class USoundBase;
+class UHealthComponent;
+class UFPSCppCharacterMovement;
+class FFireInputProcessor;
+
+/** A shot fired by the owning client, sent to the server in batches */
+USTRUCT()
+struct FFiredShot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	/** Server world time as seen by the client, used to rewind the other characters */
+	UPROPERTY()
+	float ClientTime = 0.f;
+
+	/** Echoed back in FConfirmedHit so the client can measure input to impact latency */
+	UPROPERTY()
+	uint8 ShotId = 0;
+};
+
+/** A hit confirmed by the server, only what clients need for the impact effect */
+USTRUCT()
+struct FConfirmedHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize ImpactPoint;
+
+	UPROPERTY()
+	uint8 ShotId = 0;
+};
 
 UCLASS(config=Game)
-class AFPSCppCharacter : public ACharacter
+class AFPSCppCharacter : public ACharacter, public IPooledActor
 {
 	GENERATED_BODY()
 public:
@@ -30,27 +71,49 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Mesh)
 	USkeletalMeshComponent* Gun;
 	
-	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = Location)
-	USceneComponent* MuzzleLocation;
+	/** Muzzle position relative to the gun */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Location)
+	FVector MuzzleOffset;
+
+	/** Muzzle flash rotation relative to the gun */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Location)
+	FRotator MuzzleRotation;
+
+	/** Grenade spawn position relative to the gun */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Location)
+	FVector GrenadeOffset;
+
+	// 相机组件运行时才创建, 蓝图里调的相机参数放在这里
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Camera)
+	float CameraArmLength;
 
-	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category=Location)
-	USceneComponent* GrenadeLocation;
+	/** Spring arm transform relative to Mesh1P */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Camera)
+	FTransform CameraArmTransform;
 
-	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category=Location)
+	/** Third person camera offset relative to the end of the spring arm */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Camera)
+	FVector TPSCameraOffset;
+
+	// 相机只在本地控制的pawn上创建, 服务器和模拟代理上为空
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category=Location)
 	USceneComponent* ZoomCameraLocation;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category = Camera)
 	USpringArmComponent* CameraSpringArm;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category = Camera)
 	UCameraComponent* TPSCameraComponent;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category = Camera)
 	UCameraComponent* ZoomInCamera;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category = Camera)
 	UCameraComponent* MainCamera;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Health)
+	UHealthComponent* HealthComponent;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Animation)
 	UAnimMontage* ReloadMontage;
 
@@ -60,6 +123,10 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Animation)
 	UAnimMontage* Ironsights_FireMontage;
 
+	/** Hit react played on death before the mesh goes ragdoll, ragdolls immediately when empty */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Animation)
+	UAnimMontage* DeathMontage;
+
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseTurnRate;
@@ -71,6 +138,10 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category= Asset)
 	TSubclassOf<AFPSCppProjectile> ProjectileClass;
 
+	/** Fire ProjectileClass bullets through UBulletSubsystem instead of hitscan */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	uint8 bFireProjectiles : 1;
+
 	UPROPERTY(EditDefaultsOnly, Category= Asset)
 	TSubclassOf<AGrenade> GrenadeClass;
 
@@ -98,68 +169,103 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
 	float ReloadTime;
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, ReplicatedUsing=OnRep_Ammo, Category= GameSetting)
 	int FullAmmo;
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, ReplicatedUsing=OnRep_Ammo, Category= GameSetting)
 	int CurrentAmmo;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
 	int PerAmmo;
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, ReplicatedUsing=OnRep_Ammo, Category= GameSetting)
 	int GrenadeCount;
 
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	EFireMode FireMode;
+
+	/** Rounds per minute */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	float FireRate;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	int BurstCount;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
 	float HitImpulse;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
 	float ShootingDistance;
 
+	/** Upper bound of shots accepted from one ServerFireShots batch, on top of the FireRate limit */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	int32 MaxShotsPerBatch;
+
+	/** How far a client shot may start from the server's view location */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	float MaxShotOriginError;
+
+	/** Seconds the body stays down before the player respawns */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= GameSetting)
+	float RespawnDelay;
+
+	// 状态位打包成位域, 复制和蓝图访问不变
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category= Gameplay)
-	bool bAbleToFire;
+	uint8 bAbleToFire : 1;
 
-	UPROPERTY(BlueprintReadWrite, Category= GamePlay)
-	bool bIsFiring = false;
+	UPROPERTY(BlueprintReadWrite, Replicated, Category= GamePlay)
+	uint8 bIsFiring : 1;
 
-	UPROPERTY(BlueprintReadWrite, Category=GamePlay)
-	bool bIsReloading = false;;
+	UPROPERTY(BlueprintReadWrite, Replicated, Category=GamePlay)
+	uint8 bIsReloading : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GamePlay)
-	bool bIsCrouching = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category=GamePlay)
+	uint8 bIsCrouching : 1;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=GamePlay)
-	bool bAbleToCrouch;
+	uint8 bAbleToCrouch : 1;
 
-	UPROPERTY(BlueprintReadWrite, Category=GamePlay)
-	bool bIsZooming = false;;
+	UPROPERTY(BlueprintReadWrite, Replicated, Category=GamePlay)
+	uint8 bIsZooming : 1;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=GamePlay)
-	bool bAbleToZoomIn;
+	uint8 bAbleToZoomIn : 1;
 
 	UPROPERTY(BlueprintReadWrite, Category=GamePlay)
-	bool bIsJumping = false;;
+	uint8 bIsJumping : 1;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=GamePlay)
-	bool bAbleToJump;
+	uint8 bAbleToJump : 1;
 
-	UPROPERTY(BlueprintReadWrite, Category=GamePlay)
-	bool bIsRunning = false;;
+	UPROPERTY(BlueprintReadWrite, Replicated, Category=GamePlay)
+	uint8 bIsRunning : 1;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=GamePlay)
-	bool bAbleToRun;
+	uint8 bAbleToRun : 1;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=GamePlay)
-	bool bAbleToUseGrenade;
+	uint8 bAbleToUseGrenade : 1;
+
+	UPROPERTY(BlueprintReadOnly, Replicated, Category=GamePlay)
+	uint8 bIsDead : 1;
+
+
+	FGameplayTimerHandle ReloadTimerHandle;
+	FGameplayTimerHandle GrenadeCoolDownTimerHandle;
+	FGameplayTimerHandle RagdollTimerHandle;
+	FGameplayTimerHandle RespawnTimerHandle;
 
+	FFireScheduler FireScheduler;
 
-	FTimerHandle ReloadTimerHandle;
-	FTimerHandle GrenadeCoolDownTimerHandle;
+	/** GFrameCounter of the last StartFire, Tick does not advance the scheduler again in that frame */
+	uint64 FireStartFrame = 0;
 
 protected:
 
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void Tick(float DeltaSeconds) override;
 
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
@@ -175,8 +281,15 @@ protected:
     UFUNCTION(BlueprintCallable)
 	void OnFire();
 
+	UFUNCTION(BlueprintCallable)
+	void StartFire();
+
+	UFUNCTION(BlueprintCallable)
 	void StopFire();
 
+	UFUNCTION(BlueprintCallable)
+	void CycleFireMode();
+
 	UFUNCTION(BlueprintCallable)
 	void Reload();
 
@@ -217,10 +330,116 @@ protected:
 
 
 public:
-	AFPSCppCharacter();
+	AFPSCppCharacter(const FObjectInitializer& ObjectInitializer);
+
+	UFPSCppCharacterMovement* GetFPSCppMovement() const;
 
 	UFUNCTION(BlueprintCallable)
 	float FireOffset();
+
+	UFUNCTION(BlueprintCallable)
+	FVector GetMuzzleLocation() const;
+
+	UFUNCTION(BlueprintCallable)
+	FVector GetGrenadeLocation() const;
+
+	/** Applies the gameplay result of a traced shot, called by UHitscanSubsystem */
+	void ResolveShot(const FHitResult& HitResult, const FVector& Start, const FVector& End, uint8 ShotId = 0);
+
+	/** Called by FFireInputProcessor with the platform time a fire key went down */
+	void NotifyFireInput(double InputTime);
+
+	virtual void PawnClientRestart() override;
+
+	/** Binds the player actions and axes to an input component owned by a bot controller */
+	void SetupBotInput(UInputComponent* BotInputComponent);
+
+	/** Marks ammo and grenade counts dirty for replication and posts them to the gameplay event bus */
+	void NotifyAmmoChanged();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// 推送式复制: 状态只通过这些函数修改, 值真正变化时才标脏
+	void SetIsFiring(bool bNewIsFiring);
+	void SetIsReloading(bool bNewIsReloading);
+	void SetIsCrouching(bool bNewIsCrouching);
+	void SetIsZooming(bool bNewIsZooming);
+	void SetIsRunning(bool bNewIsRunning);
+	void SetIsDead(bool bNewIsDead);
+
+	virtual void OnPooledActivate() override;
+	virtual void OnPooledDeactivate() override;
+
+protected:
+	UFUNCTION()
+	void OnDied(AActor* DamageCauser);
+
+	UFUNCTION()
+	void OnRep_Ammo();
+
+	/** Every shot the client fired since the last batch, one RPC per net update however fast the weapon fires */
+	UFUNCTION(Server, Unreliable)
+	void ServerFireShots(const TArray<FFiredShot>& Shots);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastConfirmHits(const TArray<FConfirmedHit>& Hits);
+
+	UFUNCTION(Server, Reliable)
+	void ServerReload();
+
+	UFUNCTION(Server, Reliable)
+	void ServerGrenade(FRotator ThrowRotation);
+
+	/** Server side of a shot, traced by UHitscanSubsystem or simulated by UBulletSubsystem */
+	void FireShot(const FVector& Start, const FVector& Direction, float ClientTime = -1.f, uint8 ShotId = 0);
+
+	void ThrowGrenade(const FRotator& ThrowRotation);
+
+	void FlushShots();
+
+	void StartRagdoll();
+
+	void RequestRespawn();
+
+private:
+	// 基准测试直接调用OnFire
+	friend class UBenchmarkSubsystem;
+
+	void ClearTimers();
+
+	/** Current camera pose, or the eyes view point on pawns without cameras */
+	void GetAim(FVector& OutLocation, FQuat& OutRotation) const;
+
+	void UnregisterFireInput();
+
+	/** Spring arm, third person and ADS cameras, created the first time a local controller possesses the pawn */
+	void CreateCameraComponents();
+
+	// HUD只给本地玩家控制的pawn创建
+	UPROPERTY(Transient)
+	UUserWidget* PlayerStateWidgetInstance;
+
+	TArray<FFiredShot> PendingShots;
+	TArray<FConfirmedHit> PendingHits;
+	float LastShotBatchTime = 0.f;
+
+	/** Server side shots the client may still fire, refilled at FireRate between the client shot times */
+	float ServerShotBudget = 0.f;
+	float LastServerShotTime = 0.f;
+
+	TSharedPtr<FFireInputProcessor> FireInputProcessor;
+	double PendingFireInputTime = 0.0;
+
+	/** Camera pose when the pending fire press arrived, the view the player aimed with */
+	FVector PendingFireAimLocation;
+	FQuat PendingFireAimRotation;
+
+	/** Input time per ShotId for shots fired from an input, 0 for scheduled follow-up shots */
+	double ShotInputTimes[256] = {};
+	uint8 NextShotId = 0;
+
+	FTransform MeshRelativeTransform;
+	FName MeshCollisionProfile;
 	
 	
 };
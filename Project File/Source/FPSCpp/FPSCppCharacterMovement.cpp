@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPSCppCharacterMovement.h"
+#include "FPSCpp.h"
+#include "GameFramework/Character.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Corrections"), STAT_MovementCorrections, STATGROUP_FPSCpp);
+
+UFPSCppCharacterMovement::UFPSCppCharacterMovement()
+{
+	MaxWalkSpeed = 600.f;
+	WalkSpeed = 270.f;
+	CrouchSpeed = 270.f;
+	ADSSpeed = 270.f;
+	ReloadSpeed = 270.f;
+	SprintSpeed = 900.f;
+}
+
+float UFPSCppCharacterMovement::GetMaxSpeed() const
+{
+	if (MovementMode != MOVE_Walking && MovementMode != MOVE_NavWalking)
+	{
+		return Super::GetMaxSpeed();
+	}
+
+	// 减速状态取最慢的一个, 没有减速时冲刺才生效
+	float Speed = MAX_flt;
+	if (HasModifier(EMovementModifier::Walk))
+	{
+		Speed = FMath::Min(Speed, WalkSpeed);
+	}
+	if (bWantsToCrouch)
+	{
+		Speed = FMath::Min(Speed, CrouchSpeed);
+	}
+	if (HasModifier(EMovementModifier::ADS))
+	{
+		Speed = FMath::Min(Speed, ADSSpeed);
+	}
+	if (HasModifier(EMovementModifier::Reload))
+	{
+		Speed = FMath::Min(Speed, ReloadSpeed);
+	}
+	if (Speed == MAX_flt)
+	{
+		Speed = HasModifier(EMovementModifier::Sprint) ? SprintSpeed : MaxWalkSpeed;
+	}
+	return Speed;
+}
+
+void UFPSCppCharacterMovement::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	Modifiers = Flags & (FSavedMove_Character::FLAG_Custom_0 | FSavedMove_Character::FLAG_Custom_1 |
+		FSavedMove_Character::FLAG_Custom_2 | FSavedMove_Character::FLAG_Custom_3);
+}
+
+FNetworkPredictionData_Client* UFPSCppCharacterMovement::GetPredictionData_Client() const
+{
+	if (!ClientPredictionData)
+	{
+		UFPSCppCharacterMovement* MutableThis = const_cast<UFPSCppCharacterMovement*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_FPSCpp(*this);
+	}
+	return ClientPredictionData;
+}
+
+bool UFPSCppCharacterMovement::ClientUpdatePositionAfterServerUpdate()
+{
+	// 重放存档移动会按每个移动的标记改写修饰, 重放完恢复玩家当前的输入状态
+	const uint8 RealModifiers = Modifiers;
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+	Modifiers = RealModifiers;
+	return bResult;
+}
+
+void UFPSCppCharacterMovement::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData,
+                                                          float TimeStamp, FVector NewLocation, FVector NewVelocity,
+                                                          UPrimitiveComponent* NewBase, FName NewBaseBoneName,
+                                                          bool bHasBase, bool bBaseRelativePosition,
+                                                          uint8 ServerMovementMode)
+{
+	NumCorrections++;
+	INC_DWORD_STAT(STAT_MovementCorrections);
+
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName,
+	                                  bHasBase, bBaseRelativePosition, ServerMovementMode);
+}
+
+void UFPSCppCharacterMovement::SetModifier(EMovementModifier Modifier, bool bActive)
+{
+	if (bActive)
+	{
+		Modifiers |= static_cast<uint8>(Modifier);
+	}
+	else
+	{
+		Modifiers &= ~static_cast<uint8>(Modifier);
+	}
+}
+
+bool UFPSCppCharacterMovement::HasModifier(EMovementModifier Modifier) const
+{
+	return (Modifiers & static_cast<uint8>(Modifier)) != 0;
+}
+
+void UFPSCppCharacterMovement::SetCrouchModifier(bool bActive)
+{
+	// bCanCrouch 保持关闭, bWantsToCrouch 只作为预测标记, 胶囊体不会真的缩小
+	bWantsToCrouch = bActive;
+}
+
+void UFPSCppCharacterMovement::ClearModifiers()
+{
+	Modifiers = 0;
+	bWantsToCrouch = false;
+}
+
+void FSavedMove_FPSCpp::Clear()
+{
+	Super::Clear();
+	SavedModifiers = 0;
+}
+
+uint8 FSavedMove_FPSCpp::GetCompressedFlags() const
+{
+	return Super::GetCompressedFlags() | SavedModifiers;
+}
+
+bool FSavedMove_FPSCpp::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	if (SavedModifiers != static_cast<const FSavedMove_FPSCpp*>(NewMove.Get())->SavedModifiers)
+	{
+		return false;
+	}
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_FPSCpp::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel,
+                                   FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	if (const UFPSCppCharacterMovement* Movement = Cast<UFPSCppCharacterMovement>(Character->GetCharacterMovement()))
+	{
+		SavedModifiers = Movement->GetModifiers();
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_FPSCpp::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_FPSCpp());
+}
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "FPSCppCharacterMovement.generated.h"
+
+/** Movement modifiers, each one maps to a custom saved move flag. Crouch rides on bWantsToCrouch */
+enum class EMovementModifier : uint8
+{
+	Walk = FSavedMove_Character::FLAG_Custom_0,
+	ADS = FSavedMove_Character::FLAG_Custom_1,
+	Reload = FSavedMove_Character::FLAG_Custom_2,
+	Sprint = FSavedMove_Character::FLAG_Custom_3,
+};
+
+/**
+ * Resolves walking speed from a stack of modifiers instead of gameplay code writing MaxWalkSpeed.
+ * The modifiers are sent with every saved move, so the server simulates the same speed as the client.
+ * The slowest active modifier wins, sprint only applies when nothing slows the character down.
+ * The capsule never really crouches, crouch only slows down like it did before.
+ */
+UCLASS()
+class FPSCPP_API UFPSCppCharacterMovement : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFPSCppCharacterMovement();
+
+	virtual float GetMaxSpeed() const override;
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+
+	virtual void OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp,
+	                                        FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase,
+	                                        FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition,
+	                                        uint8 ServerMovementMode) override;
+
+	void SetModifier(EMovementModifier Modifier, bool bActive);
+
+	bool HasModifier(EMovementModifier Modifier) const;
+
+	void SetCrouchModifier(bool bActive);
+
+	void ClearModifiers();
+
+	uint8 GetModifiers() const { return Modifiers; }
+
+	/** Corrections this client received from the server since the component was created */
+	int32 GetNumCorrections() const { return NumCorrections; }
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Modifiers")
+	float WalkSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Modifiers")
+	float CrouchSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Modifiers")
+	float ADSSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Modifiers")
+	float ReloadSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Modifiers")
+	float SprintSpeed;
+
+private:
+	/** EMovementModifier bits */
+	uint8 Modifiers = 0;
+
+	int32 NumCorrections = 0;
+};
+
+class FSavedMove_FPSCpp : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel,
+	                        FNetworkPredictionData_Client_Character& ClientData) override;
+
+	uint8 SavedModifiers = 0;
+};
+
+class FNetworkPredictionData_Client_FPSCpp : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	explicit FNetworkPredictionData_Client_FPSCpp(const UCharacterMovementComponent& ClientMovement)
+		: Super(ClientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
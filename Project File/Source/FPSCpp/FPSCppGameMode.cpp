@@ -1,11 +1,16 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FPSCppGameMode.h"
+#include "FPSCpp.h"
+#include "ActorPoolSubsystem.h"
 #include "FPSCppHUD.h"
 #include "FPSCppCharacter.h"
 #include "UObject/ConstructorHelpers.h"
 #include "MyGameStateBase.h"
 
+// 池子未命中时包含完整的构造, 用来比较每个pawn的生成开销
+DECLARE_CYCLE_STAT(TEXT("Pawn Spawn"), STAT_PawnSpawn, STATGROUP_FPSCpp);
+
 AFPSCppGameMode::AFPSCppGameMode()
 	: Super()
 {
@@ -17,11 +22,59 @@ AFPSCppGameMode::AFPSCppGameMode()
 	HUDClass = AFPSCppHUD::StaticClass();
 	LevelTime = 100;
 	Timer = LevelTime;
+	GrenadePoolSize = 8;
 }
 
 void AFPSCppGameMode::BeginPlay()
 {
+	Super::BeginPlay();
 	Timer = LevelTime;
+
+	//开局预先生成手雷, 避免对局中生成. 子弹由UBulletSubsystem模拟, 不用actor
+	const AFPSCppCharacter* DefaultCharacter = DefaultPawnClass ? Cast<AFPSCppCharacter>(DefaultPawnClass->GetDefaultObject()) : nullptr;
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	if (DefaultCharacter && ActorPool)
+	{
+		ActorPool->Prewarm(DefaultCharacter->GrenadeClass, GrenadePoolSize);
+	}
+}
+
+APawn* AFPSCppGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_PawnSpawn);
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	if (!ActorPool)
+	{
+		return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+	}
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.Instigator = GetInstigator();
+	SpawnInfo.ObjectFlags |= RF_Transient;
+	return ActorPool->Acquire<APawn>(GetDefaultPawnClassForController(NewPlayer), SpawnTransform, SpawnInfo);
+}
+
+void AFPSCppGameMode::RespawnPlayer(AController* Controller)
+{
+	if (!Controller)
+	{
+		return;
+	}
+
+	APawn* DeadPawn = Controller->GetPawn();
+	Controller->UnPossess();
+
+	//先放回池子, 重生时就能直接拿到这个pawn, 不用重新生成
+	if (UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+	{
+		ActorPool->Release(DeadPawn);
+	}
+	else if (DeadPawn)
+	{
+		DeadPawn->Destroy();
+	}
+
+	RestartPlayer(Controller);
 }
 
 void AFPSCppGameMode::GameEnd()
@@ -17,6 +17,10 @@ public:
 	
 	float LevelTime;
 	float Timer;
+
+	/** Grenades spawned into the actor pool when the match starts */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Pool)
+	int32 GrenadePoolSize;
 	
 
 public:
@@ -26,6 +30,11 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void GameEnd();
 
+	/** Returns the controller's dead pawn to the actor pool and restarts the player with a pooled pawn */
+	void RespawnPlayer(AController* Controller);
+
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
 	UFUNCTION(BlueprintNativeEvent)
 	void OnVictory();
 
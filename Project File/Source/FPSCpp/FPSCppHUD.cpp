@@ -1,12 +1,15 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FPSCppHUD.h"
+#include "FPSCpp.h"
 #include "Engine/Canvas.h"
 #include "Engine/Texture2D.h"
 #include "TextureResource.h"
 #include "CanvasItem.h"
 #include "UObject/ConstructorHelpers.h"
 
+DECLARE_CYCLE_STAT(TEXT("HUD Draw"), STAT_HUDDraw, STATGROUP_FPSCpp);
+
 AFPSCppHUD::AFPSCppHUD()
 {
 	// Set the crosshair texture
@@ -17,6 +20,7 @@ AFPSCppHUD::AFPSCppHUD()
 
 void AFPSCppHUD::DrawHUD()
 {
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_HUDDraw);
 	Super::DrawHUD();
 
 	// Draw very simple crosshair
@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPSCppMemory.h"
+#include "FPSCpp.h"
+#include "FPSCppCharacter.h"
+#include "FPSCppProjectile.h"
+#include "Grenade.h"
+#include "Target.h"
+#include "TargetField.h"
+#include "EngineUtils.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp Characters"), STAT_FPSCppCharactersLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp Weapons"), STAT_FPSCppWeaponsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp Projectiles"), STAT_FPSCppProjectilesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp Grenades"), STAT_FPSCppGrenadesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp Targets"), STAT_FPSCppTargetsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp Effects"), STAT_FPSCppEffectsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("FPSCpp"), STAT_FPSCppSummaryLLM, STATGROUP_LLM);
+
+static const TCHAR* TagNames[] = {TEXT("Characters"), TEXT("Weapons"), TEXT("Projectiles"), TEXT("Grenades"), TEXT("Targets"), TEXT("Effects")};
+
+static constexpr int32 NumTags = static_cast<int32>(EFPSCppLLMTag::Last) - static_cast<int32>(EFPSCppLLMTag::Characters) + 1;
+static_assert(UE_ARRAY_COUNT(TagNames) == NumTags, "Every LLM tag needs a name");
+
+static int32 TagIndex(EFPSCppLLMTag Tag)
+{
+	return static_cast<int32>(Tag) - static_cast<int32>(EFPSCppLLMTag::Characters);
+}
+
+void FFPSCppMemory::RegisterTags()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER && STATS
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	Tracker.RegisterProjectTag(static_cast<int32>(EFPSCppLLMTag::Characters), TEXT("FPSCppCharacters"),
+	                           GET_STATFNAME(STAT_FPSCppCharactersLLM), GET_STATFNAME(STAT_FPSCppSummaryLLM));
+	Tracker.RegisterProjectTag(static_cast<int32>(EFPSCppLLMTag::Weapons), TEXT("FPSCppWeapons"),
+	                           GET_STATFNAME(STAT_FPSCppWeaponsLLM), GET_STATFNAME(STAT_FPSCppSummaryLLM));
+	Tracker.RegisterProjectTag(static_cast<int32>(EFPSCppLLMTag::Projectiles), TEXT("FPSCppProjectiles"),
+	                           GET_STATFNAME(STAT_FPSCppProjectilesLLM), GET_STATFNAME(STAT_FPSCppSummaryLLM));
+	Tracker.RegisterProjectTag(static_cast<int32>(EFPSCppLLMTag::Grenades), TEXT("FPSCppGrenades"),
+	                           GET_STATFNAME(STAT_FPSCppGrenadesLLM), GET_STATFNAME(STAT_FPSCppSummaryLLM));
+	Tracker.RegisterProjectTag(static_cast<int32>(EFPSCppLLMTag::Targets), TEXT("FPSCppTargets"),
+	                           GET_STATFNAME(STAT_FPSCppTargetsLLM), GET_STATFNAME(STAT_FPSCppSummaryLLM));
+	Tracker.RegisterProjectTag(static_cast<int32>(EFPSCppLLMTag::Effects), TEXT("FPSCppEffects"),
+	                           GET_STATFNAME(STAT_FPSCppEffectsLLM), GET_STATFNAME(STAT_FPSCppSummaryLLM));
+#endif
+}
+
+bool FFPSCppMemory::TryGetTagForClass(const UClass* Class, EFPSCppLLMTag& OutTag)
+{
+	if (!Class)
+	{
+		return false;
+	}
+	if (Class->IsChildOf<AFPSCppCharacter>())
+	{
+		OutTag = EFPSCppLLMTag::Characters;
+	}
+	else if (Class->IsChildOf<AFPSCppProjectile>())
+	{
+		OutTag = EFPSCppLLMTag::Projectiles;
+	}
+	else if (Class->IsChildOf<AGrenade>())
+	{
+		OutTag = EFPSCppLLMTag::Grenades;
+	}
+	else if (Class->IsChildOf<ATarget>() || Class->IsChildOf<ATargetField>())
+	{
+		OutTag = EFPSCppLLMTag::Targets;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+/** The object itself plus the resources only it owns, Exclusive alone is 0 for plain actors and components */
+static SIZE_T GetObjectSize(UObject* Object)
+{
+	return Object->GetClass()->GetStructureSize() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+}
+
+void FFPSCppMemory::Report(UWorld* World)
+{
+	int32 Counts[NumTags] = {};
+	SIZE_T Bytes[NumTags] = {};
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+		EFPSCppLLMTag Tag;
+		if (!TryGetTagForClass(Actor->GetClass(), Tag))
+		{
+			continue;
+		}
+
+		// 枪和挂在枪上的组件算到武器里
+		TArray<USceneComponent*> WeaponComponents;
+		if (AFPSCppCharacter* Character = Cast<AFPSCppCharacter>(Actor))
+		{
+			if (Character->Gun)
+			{
+				Character->Gun->GetChildrenComponents(true, WeaponComponents);
+				WeaponComponents.Add(Character->Gun);
+			}
+			Counts[TagIndex(EFPSCppLLMTag::Weapons)]++;
+		}
+
+		Counts[TagIndex(Tag)]++;
+		Bytes[TagIndex(Tag)] += GetObjectSize(Actor);
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			const bool bWeapon = WeaponComponents.Contains(Cast<USceneComponent>(Component));
+			Bytes[TagIndex(bWeapon ? EFPSCppLLMTag::Weapons : Tag)] += GetObjectSize(Component);
+		}
+	}
+
+	// 特效池的组件没有owner
+	for (TObjectIterator<UParticleSystemComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == World && !It->GetOwner())
+		{
+			Counts[TagIndex(EFPSCppLLMTag::Effects)]++;
+			Bytes[TagIndex(EFPSCppLLMTag::Effects)] += GetObjectSize(*It);
+		}
+	}
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	const bool bLLM = FLowLevelMemTracker::IsEnabled();
+#else
+	const bool bLLM = false;
+#endif
+	UE_LOG(LogFPSCpp, Display, TEXT("FPSCpp memory%s:"), bLLM ? TEXT("") : TEXT(" (run with -llm for tracked allocations)"));
+	UE_LOG(LogFPSCpp, Display, TEXT("  %-11s %6s %12s %12s %12s %12s"), TEXT("Kind"), TEXT("Count"), TEXT("LLM KB"),
+	       TEXT("LLM B/each"), TEXT("Object KB"), TEXT("Obj B/each"));
+	for (int32 Index = 0; Index < NumTags; ++Index)
+	{
+		int64 TrackedBytes = 0;
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		if (bLLM)
+		{
+			const ELLMTag Tag = static_cast<ELLMTag>(static_cast<int32>(EFPSCppLLMTag::Characters) + Index);
+			TrackedBytes = FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, Tag);
+		}
+#endif
+		const int32 Count = FMath::Max(Counts[Index], 1);
+		UE_LOG(LogFPSCpp, Display, TEXT("  %-11s %6d %12.1f %12lld %12.1f %12llu"), TagNames[Index], Counts[Index],
+		       TrackedBytes / 1024.0, TrackedBytes / Count, Bytes[Index] / 1024.0, (uint64)(Bytes[Index] / Count));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs MemReportCommand(
+	TEXT("fpscpp.Mem.Report"),
+	TEXT("Logs LLM tracked and object bytes of characters, weapons, projectiles, grenades, targets and effects, in total and per entity"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World)
+		{
+			FFPSCppMemory::Report(World);
+		}
+	}));
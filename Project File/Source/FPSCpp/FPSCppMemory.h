@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+/** LLM project tags of the module, visible with -llm in stat LLMFULL and the llm csv */
+enum class EFPSCppLLMTag : uint8
+{
+	Characters = static_cast<uint8>(ELLMTag::ProjectTagStart),
+	Weapons,
+	Projectiles,
+	Grenades,
+	Targets,
+	Effects,
+	Last = Effects
+};
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#define FPSCPP_LLM_SCOPE(Tag) LLM_SCOPE(static_cast<ELLMTag>(Tag))
+#else
+#define FPSCPP_LLM_SCOPE(Tag)
+#endif
+
+/**
+ * Memory attribution for characters, weapons, projectiles, grenades, targets and effects.
+ * fpscpp.Mem.Report logs the LLM total of each tag and the object plus exclusive resource size of the live
+ * entities, both divided by the number of entities, so each kind has a per entity byte cost to budget against.
+ * Weapons are counted per gun, projectile actors and their allocations go to their own tag.
+ */
+struct FPSCPP_API FFPSCppMemory
+{
+	/** Registers the project tags with LLM, called once on module startup */
+	static void RegisterTags();
+
+	/** Tag for actors of Class, false for classes the module does not track */
+	static bool TryGetTagForClass(const UClass* Class, EFPSCppLLMTag& OutTag);
+
+	static void Report(UWorld* World);
+};
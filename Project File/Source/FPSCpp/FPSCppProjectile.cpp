@@ -2,7 +2,11 @@
 
 #include "FPSCppProjectile.h"
 
-#include "Target.h"
+#include "ActorPoolSubsystem.h"
+#include "DamageReceiver.h"
+#include "DamageRegistrySubsystem.h"
+#include "EffectPoolSubsystem.h"
+#include "GameplayEventSubsystem.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
 #include "Kismet/GameplayStatics.h"
@@ -31,21 +35,96 @@ AFPSCppProjectile::AFPSCppProjectile()
 	ProjectileMovement->bShouldBounce = true;
 	
 
-	// Die after 3 seconds by default
-	InitialLifeSpan = 3.0f;
+	DragCoefficient = 0.f;
+	Damage = 0.f;
+
+	// Return to the pool after 3 seconds by default
+	LifeSpan = 3.0f;
+}
+
+void AFPSCppProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+	StartLifeSpan();
+}
+
+void AFPSCppProjectile::StartLifeSpan()
+{
+	if (LifeSpan > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(LifeSpanTimerHandle, this, &AFPSCppProjectile::ReturnToPool, LifeSpan, false);
+	}
+}
+
+void AFPSCppProjectile::ReturnToPool()
+{
+	if (UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+	{
+		ActorPool->Release(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void AFPSCppProjectile::OnPooledActivate()
+{
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// 与新生成时一致: 沿朝向以初速度飞出
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = GetActorForwardVector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->Activate(true);
+
+	StartLifeSpan();
+}
+
+void AFPSCppProjectile::OnPooledDeactivate()
+{
+	GetWorldTimerManager().ClearTimer(LifeSpanTimerHandle);
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
 }
 
 void AFPSCppProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	// Only add impulse and destroy projectile if we hit a physics
-	if ((OtherActor != nullptr) && (OtherActor != this) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
+	if (OtherActor != this)
+	{
+		ApplyImpact(GetWorld(), Hit, GetVelocity(), GetActorLocation(), HitParticle, Damage, GetInstigator());
+	}
+	ReturnToPool();
+}
+
+void AFPSCppProjectile::ApplyImpact(UWorld* World, const FHitResult& Hit, const FVector& Velocity,
+                                   const FVector& ImpulseLocation, UParticleSystem* ImpactParticle,
+                                   float Damage, AActor* DamageCauser)
+{
+	AActor* OtherActor = Hit.GetActor();
+	UPrimitiveComponent* OtherComp = Hit.GetComponent();
+
+	// Only add impulse if we hit a physics
+	if ((OtherActor != nullptr) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
+	{
+		OtherComp->AddImpulseAtLocation(Velocity * 20.0f, ImpulseLocation);
+	}
+	//与射线命中一样走伤害注册表
+	UDamageRegistrySubsystem* Registry = World->GetSubsystem<UDamageRegistrySubsystem>();
+	if (IDamageReceiver* Receiver = Registry ? Registry->FindReceiver(OtherActor) : nullptr)
 	{
-		OtherComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
+		Receiver->ReceiveDamage(Damage, Hit, DamageCauser);
+
+		UGameplayEventSubsystem* Events = World->GetSubsystem<UGameplayEventSubsystem>();
+		if (Events && Damage > 0.f)
+		{
+			Events->Post(FDamageAppliedEvent{OtherActor, DamageCauser, Damage});
+		}
 	}
-	if(OtherActor->IsA<ATarget>())
+	if (UEffectPoolSubsystem* EffectPool = World->GetSubsystem<UEffectPoolSubsystem>())
 	{
-		Cast<ATarget>(OtherActor)->Hitted();
+		EffectPool->SpawnAtLocation(ImpactParticle,Hit.Location,FRotator::ZeroRotator,FVector(.2f));
 	}
-	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(),HitParticle,Hit.Location,FRotator::ZeroRotator,FVector(.2f));
-	Destroy();
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PooledActor.h"
 #include "GameFramework/Actor.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "FPSCppProjectile.generated.h"
@@ -11,7 +12,7 @@ class USphereComponent;
 class UProjectileMovementComponent;
 
 UCLASS(config=Game)
-class AFPSCppProjectile : public AActor
+class AFPSCppProjectile : public AActor, public IPooledActor
 {
 	GENERATED_BODY()
 
@@ -29,6 +30,23 @@ class AFPSCppProjectile : public AActor
 public:
 	AFPSCppProjectile();
 
+	/** Quadratic air drag, only used when the bullet is simulated by UBulletSubsystem */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Projectile)
+	float DragCoefficient;
+
+	/** Seconds before the projectile is returned to the actor pool */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Projectile)
+	float LifeSpan;
+
+	/** Damage passed to the receiver of the hit actor, targets score on any hit */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Projectile)
+	float Damage;
+
+	virtual void BeginPlay() override;
+
+	virtual void OnPooledActivate() override;
+	virtual void OnPooledDeactivate() override;
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse,
@@ -39,7 +57,21 @@ public:
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
 
+	UParticleSystem* GetHitParticle() const { return HitParticle; }
+
 	void FireInDirection(const FVector& Direction);
+
+	/** Impulse, damage through UDamageRegistrySubsystem and impact effect shared by projectile actors and simulated bullets */
+	static void ApplyImpact(UWorld* World, const FHitResult& Hit, const FVector& Velocity,
+	                        const FVector& ImpulseLocation, UParticleSystem* ImpactParticle,
+	                        float Damage, AActor* DamageCauser);
+
+private:
+	void StartLifeSpan();
+
+	void ReturnToPool();
+
+	FTimerHandle LifeSpanTimerHandle;
 };
 
 inline void AFPSCppProjectile::FireInDirection(const FVector& Direction)
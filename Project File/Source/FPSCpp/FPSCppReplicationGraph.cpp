@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPSCppReplicationGraph.h"
+#include "FPSCppCharacter.h"
+#include "Grenade.h"
+#include "Target.h"
+#include "TargetField.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+
+static const TCHAR* LexMappingName(EClassRepNodeMapping Mapping)
+{
+	switch (Mapping)
+	{
+	case EClassRepNodeMapping::NotRouted: return TEXT("NotRouted");
+	case EClassRepNodeMapping::RelevantAllConnections: return TEXT("RelevantAllConnections");
+	case EClassRepNodeMapping::Spatialize_Static: return TEXT("Spatialize_Static");
+	case EClassRepNodeMapping::Spatialize_Dynamic: return TEXT("Spatialize_Dynamic");
+	case EClassRepNodeMapping::Spatialize_Dormancy: return TEXT("Spatialize_Dormancy");
+	default: return TEXT("Unknown");
+	}
+}
+
+static bool IsSpatialized(EClassRepNodeMapping Mapping)
+{
+	return Mapping >= EClassRepNodeMapping::Spatialize_Static;
+}
+
+void UFPSCppReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// 没有单独规则的actor都放进网格, 由子类覆盖
+	ClassRepNodePolicies.Set(AActor::StaticClass(), EClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AInfo::StaticClass(), EClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), EClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), EClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(AFPSCppCharacter::StaticClass(), EClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AGrenade::StaticClass(), EClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(ATargetField::StaticClass(), EClassRepNodeMapping::Spatialize_Dormancy);
+	ClassRepNodePolicies.Set(ATarget::StaticClass(), EClassRepNodeMapping::Spatialize_Dormancy);
+
+	// Update frequency and cull distance come from each replicated class' defaults
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+		const FString ClassName = Class->GetName();
+		if (ClassName.StartsWith(TEXT("SKEL_")) || ClassName.StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const EClassRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Class);
+		FClassReplicationInfo Info;
+		InitClassReplicationInfo(Info, Class, Mapping && IsSpatialized(*Mapping));
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, Info);
+	}
+}
+
+void UFPSCppReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class,
+                                                       bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	if (bSpatialize)
+	{
+		Info.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+
+	const float ServerMaxTickRate = NetDriver ? NetDriver->NetServerMaxTickRate : 30.f;
+	Info.ReplicationPeriodFrame = FMath::Max<uint32>(
+		FMath::RoundToInt(ServerMaxTickRate / FMath::Max(ActorCDO->NetUpdateFrequency, 1.f)), 1);
+}
+
+void UFPSCppReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UFPSCppReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// 每个连接自己的控制器和pawn
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnection =
+		CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnection, RepGraphConnection);
+}
+
+EClassRepNodeMapping UFPSCppReplicationGraph::GetMappingPolicy(const AActor* Actor)
+{
+	// 实例上的设置优先于类规则
+	if (Actor->bAlwaysRelevant)
+	{
+		return EClassRepNodeMapping::RelevantAllConnections;
+	}
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		return EClassRepNodeMapping::NotRouted;
+	}
+
+	const EClassRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Actor->GetClass());
+	return Mapping ? *Mapping : EClassRepNodeMapping::NotRouted;
+}
+
+void UFPSCppReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo,
+                                                          FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const EClassRepNodeMapping Mapping = GetMappingPolicy(ActorInfo.Actor);
+	NumRouted[static_cast<uint8>(Mapping)]++;
+
+	switch (Mapping)
+	{
+	case EClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UFPSCppReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const EClassRepNodeMapping Mapping = GetMappingPolicy(ActorInfo.Actor);
+	NumRouted[static_cast<uint8>(Mapping)]--;
+
+	switch (Mapping)
+	{
+	case EClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UFPSCppReplicationGraph::Report() const
+{
+	UE_LOG(LogTemp, Display, TEXT("Replication graph: %d connections, grid cell %.0f"), Connections.Num(), GridCellSize);
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(NumRouted); ++Index)
+	{
+		UE_LOG(LogTemp, Display, TEXT("  %-24s %6d actors"), LexMappingName(static_cast<EClassRepNodeMapping>(Index)),
+		       NumRouted[Index]);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GraphReportCommand(
+	TEXT("fpscpp.Net.GraphReport"),
+	TEXT("Logs the replication graph's connections and routed actors per node"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UNetDriver* Driver = World ? World->GetNetDriver() : nullptr;
+		const UFPSCppReplicationGraph* Graph = Driver ? Cast<UFPSCppReplicationGraph>(Driver->GetReplicationDriver()) : nullptr;
+		if (!Graph)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("fpscpp.Net.GraphReport needs a server running UFPSCppReplicationGraph"));
+			return;
+		}
+		Graph->Report();
+	}));
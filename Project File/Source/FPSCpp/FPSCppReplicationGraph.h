@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "FPSCppReplicationGraph.generated.h"
+
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+/** Which global node an actor class is routed to */
+enum class EClassRepNodeMapping : uint8
+{
+	/** Not added to any global node, e.g. player controllers which only replicate to their own connection */
+	NotRouted,
+	RelevantAllConnections,
+	/** Spatialized, never moves */
+	Spatialize_Static,
+	/** Spatialized, moves every frame */
+	Spatialize_Dynamic,
+	/** Spatialized, treated as static while dormant */
+	Spatialize_Dormancy,
+};
+
+/**
+ * Replaces the per connection relevancy and priority pass of the default net driver. Characters and
+ * grenades are gathered from a 2D grid by the viewer's cell, the game state and player states are always
+ * relevant, target fields and targets wake up from dormancy only when they change.
+ * Enabled through ReplicationDriverClassName in DefaultEngine.ini. For comparisons, start the server with
+ * -ini:Engine:[/Script/OnlineSubsystemUtils.IpNetDriver]:ReplicationDriverClassName= to use the default path.
+ */
+UCLASS(transient)
+class FPSCPP_API UFPSCppReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo,
+	                                         FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	/** Logs connections and routed actors per node, for fpscpp.Net.GraphReport */
+	void Report() const;
+
+	UPROPERTY(config)
+	float GridCellSize = 10000.f;
+
+	/** Grid origin, should cover the most negative X/Y of the map */
+	UPROPERTY(config)
+	float SpatialBiasX = -150000.f;
+
+	UPROPERTY(config)
+	float SpatialBiasY = -200000.f;
+
+private:
+	EClassRepNodeMapping GetMappingPolicy(const AActor* Actor);
+
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const;
+
+	TClassMap<EClassRepNodeMapping> ClassRepNodePolicies;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	int32 NumRouted[5] = {};
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireInputProcessor.h"
+#include "FPSCpp.h"
+#include "FPSCppCharacter.h"
+#include "GameFramework/InputSettings.h"
+#include "Input/Events.h"
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Fire Input To Shot (ms)"), STAT_FireInputToShot, STATGROUP_FPSCpp);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Fire Input To Impact (ms)"), STAT_FireInputToImpact, STATGROUP_FPSCpp);
+
+FFireInputProcessor::FFireInputProcessor(AFPSCppCharacter* InCharacter)
+	: Character(InCharacter)
+{
+	TArray<FInputActionKeyMapping> Mappings;
+	UInputSettings::GetInputSettings()->GetActionMappingByName(TEXT("Fire"), Mappings);
+	for (const FInputActionKeyMapping& Mapping : Mappings)
+	{
+		FireKeys.AddUnique(Mapping.Key);
+	}
+}
+
+void FFireInputProcessor::Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor)
+{
+}
+
+bool FFireInputProcessor::HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent)
+{
+	if (!InKeyEvent.IsRepeat())
+	{
+		RecordPress(InKeyEvent.GetKey());
+	}
+	return false;
+}
+
+bool FFireInputProcessor::HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent)
+{
+	RecordPress(MouseEvent.GetEffectingButton());
+	return false;
+}
+
+bool FFireInputProcessor::HandleMouseButtonDoubleClickEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent)
+{
+	// 快速连点的第二下是双击事件, 不是按下事件
+	RecordPress(MouseEvent.GetEffectingButton());
+	return false;
+}
+
+void FFireInputProcessor::RecordPress(const FKey& Key)
+{
+	// 只记录时间, 不吞掉事件, 开火仍然走正常的输入绑定
+	AFPSCppCharacter* Owner = Character.Get();
+	if (Owner && FireKeys.Contains(Key))
+	{
+		Owner->NotifyFireInput(FPlatformTime::Seconds());
+	}
+}
+
+struct FFireLatencyTotals
+{
+	double InputToShot = 0.0;
+	double InputToImpact = 0.0;
+	int32 NumShots = 0;
+	int32 NumImpacts = 0;
+};
+
+static FFireLatencyTotals LatencyTotals;
+
+void FFireLatencyStats::RecordShot(double InputTime)
+{
+	const double Seconds = FPlatformTime::Seconds() - InputTime;
+	LatencyTotals.InputToShot += Seconds;
+	LatencyTotals.NumShots++;
+	SET_FLOAT_STAT(STAT_FireInputToShot, Seconds * 1000.0);
+}
+
+void FFireLatencyStats::RecordImpact(double InputTime)
+{
+	const double Seconds = FPlatformTime::Seconds() - InputTime;
+	LatencyTotals.InputToImpact += Seconds;
+	LatencyTotals.NumImpacts++;
+	SET_FLOAT_STAT(STAT_FireInputToImpact, Seconds * 1000.0);
+}
+
+double FFireLatencyStats::GetAverageInputToShot()
+{
+	return LatencyTotals.NumShots > 0 ? LatencyTotals.InputToShot / LatencyTotals.NumShots : 0.0;
+}
+
+double FFireLatencyStats::GetAverageInputToImpact()
+{
+	return LatencyTotals.NumImpacts > 0 ? LatencyTotals.InputToImpact / LatencyTotals.NumImpacts : 0.0;
+}
+
+void FFireLatencyStats::Report(bool bReset)
+{
+	UE_LOG(LogTemp, Display, TEXT("Fire latency: input to shot avg %.2f ms over %d shots, input to impact avg %.2f ms over %d impacts"),
+	       GetAverageInputToShot() * 1000.0, LatencyTotals.NumShots,
+	       GetAverageInputToImpact() * 1000.0, LatencyTotals.NumImpacts);
+	if (bReset)
+	{
+		LatencyTotals = FFireLatencyTotals();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs LatencyReportCommand(
+	TEXT("fpscpp.Input.LatencyReport"),
+	TEXT("Logs the average fire input to shot and input to impact effect latency. Usage: fpscpp.Input.LatencyReport [reset]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FFireLatencyStats::Report(Args.Num() > 0 && Args[0] == TEXT("reset"));
+	}));
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Framework/Application/IInputProcessor.h"
+
+class AFPSCppCharacter;
+
+/**
+ * Stamps fire presses with FPlatformTime::Seconds() as soon as Slate receives them, before they are
+ * routed through the player input stack, so the shot can be aimed where the camera was at that instant.
+ */
+class FFireInputProcessor : public IInputProcessor
+{
+public:
+	explicit FFireInputProcessor(AFPSCppCharacter* InCharacter);
+
+	virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override;
+	virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override;
+	virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override;
+	virtual bool HandleMouseButtonDoubleClickEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override;
+	virtual const TCHAR* GetDebugName() const override { return TEXT("FPSCppFireInput"); }
+
+private:
+	void RecordPress(const FKey& Key);
+
+	TWeakObjectPtr<AFPSCppCharacter> Character;
+
+	/** Keys bound to the Fire action */
+	TArray<FKey> FireKeys;
+};
+
+/** Input to shot and input to impact effect latency, averaged since the last reset */
+struct FPSCPP_API FFireLatencyStats
+{
+	static void RecordShot(double InputTime);
+
+	static void RecordImpact(double InputTime);
+
+	static void Report(bool bReset);
+
+	static double GetAverageInputToShot();
+
+	static double GetAverageInputToImpact();
+};
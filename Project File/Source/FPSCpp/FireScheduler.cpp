@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireScheduler.h"
+
+// 浮点累加误差容忍, 防止 1/15 - 2 * 1/30 这类情况少打一发
+static constexpr double FireSchedulerTolerance = 1e-6;
+
+void FFireScheduler::SetRoundsPerMinute(float RoundsPerMinute)
+{
+	Interval = 60.0 / FMath::Max(RoundsPerMinute, 1.f);
+}
+
+void FFireScheduler::Press(EFireMode Mode, int32 BurstCount)
+{
+	switch (Mode)
+	{
+	case EFireMode::Semi:
+		ShotsRemaining = 1;
+		break;
+	case EFireMode::Burst:
+		ShotsRemaining = FMath::Max(BurstCount, 1);
+		break;
+	case EFireMode::FullAuto:
+		ShotsRemaining = -1;
+		break;
+	}
+}
+
+void FFireScheduler::Release()
+{
+	// Semi and Burst finish the shots they queued, only FullAuto stops with the trigger
+	if (ShotsRemaining < 0)
+	{
+		ShotsRemaining = 0;
+	}
+}
+
+void FFireScheduler::Stop()
+{
+	ShotsRemaining = 0;
+}
+
+int32 FFireScheduler::Advance(float DeltaSeconds)
+{
+	Cooldown -= DeltaSeconds;
+
+	int32 Shots = 0;
+	while (ShotsRemaining != 0 && Cooldown <= FireSchedulerTolerance)
+	{
+		Shots++;
+		Cooldown += Interval;
+		if (ShotsRemaining > 0)
+		{
+			ShotsRemaining--;
+		}
+	}
+
+	// Idle time must not be banked as extra shots for the next trigger pull
+	if (ShotsRemaining == 0)
+	{
+		Cooldown = FMath::Max(Cooldown, 0.0);
+	}
+
+	return Shots;
+}
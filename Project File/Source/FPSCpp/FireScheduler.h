@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireScheduler.generated.h"
+
+UENUM(BlueprintType)
+enum class EFireMode : uint8
+{
+	Semi,
+	Burst,
+	FullAuto
+};
+
+/**
+ * Fixed-rate shot scheduler. Time left over after each shot is carried into the next frame,
+ * so the number of shots only depends on how long the trigger was held, not on the frame rate.
+ */
+struct FPSCPP_API FFireScheduler
+{
+public:
+	void SetRoundsPerMinute(float RoundsPerMinute);
+
+	/** Trigger pressed, a Semi shot or a Burst is queued and FullAuto keeps firing until Release() */
+	void Press(EFireMode Mode, int32 BurstCount);
+
+	void Release();
+
+	/** Stops any queued shots, e.g. when the weapon can no longer fire */
+	void Stop();
+
+	/** Advances the scheduler and returns how many shots are due in this frame */
+	int32 Advance(float DeltaSeconds);
+
+	bool IsActive() const { return ShotsRemaining != 0; }
+
+	double GetInterval() const { return Interval; }
+
+private:
+	/** Seconds between two shots */
+	double Interval = 60.0 / 900.0;
+
+	/** Seconds until the next shot may fire, negative while firing when a frame covers more than one interval */
+	double Cooldown = 0.0;
+
+	/** Shots still queued, -1 while a FullAuto trigger is held */
+	int32 ShotsRemaining = 0;
+};
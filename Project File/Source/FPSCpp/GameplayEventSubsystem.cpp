@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayEventSubsystem.h"
+#include "FPSCpp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Gameplay Events Flush"), STAT_GameplayEventsFlush, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gameplay Events Dispatched"), STAT_GameplayEventsDispatched, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots Fired"), STAT_ShotsFired, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Targets Hit"), STAT_TargetsHit, STATGROUP_FPSCpp);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Damage Applied"), STAT_DamageApplied, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Grenades"), STAT_LiveGrenades, STATGROUP_FPSCpp);
+
+void UGameplayEventSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// 遥测也只是一个订阅者
+	ShotFired.OnEvent.AddLambda([this](const FShotFiredEvent&)
+	{
+		INC_DWORD_STAT(STAT_ShotsFired);
+		ShotsThisSecond++;
+	});
+	TargetHit.OnEvent.AddLambda([this](const FTargetHitEvent&)
+	{
+		INC_DWORD_STAT(STAT_TargetsHit);
+		HitsThisSecond++;
+	});
+	DamageApplied.OnEvent.AddLambda([](const FDamageAppliedEvent& Event)
+	{
+		INC_FLOAT_STAT_BY(STAT_DamageApplied, Event.Damage);
+	});
+}
+
+void UGameplayEventSubsystem::Deinitialize()
+{
+	ShotFired.Reset();
+	TargetHit.Reset();
+	DamageApplied.Reset();
+	ScoreChanged.Reset();
+	AmmoChanged.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UGameplayEventSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UGameplayEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayEventSubsystem, STATGROUP_Tickables);
+}
+
+void UGameplayEventSubsystem::Tick(float DeltaTime)
+{
+	Flush();
+
+	RateSeconds += DeltaTime;
+	if (RateSeconds >= 1.f)
+	{
+		TRACE_COUNTER_SET(FPSCppShotsPerSecond, FMath::RoundToInt(ShotsThisSecond / RateSeconds));
+		TRACE_COUNTER_SET(FPSCppHitsPerSecond, FMath::RoundToInt(HitsThisSecond / RateSeconds));
+		ShotsThisSecond = 0;
+		HitsThisSecond = 0;
+		RateSeconds = 0.f;
+	}
+}
+
+void UGameplayEventSubsystem::AddLiveGrenades(int32 Delta)
+{
+	NumLiveGrenades = FMath::Max(NumLiveGrenades + Delta, 0);
+	SET_DWORD_STAT(STAT_LiveGrenades, NumLiveGrenades);
+	TRACE_COUNTER_SET(FPSCppLiveGrenades, NumLiveGrenades);
+}
+
+void UGameplayEventSubsystem::Flush()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GameplayEventsFlush);
+
+	// 按因果顺序分发: 命中会改分数, 所以分数和弹药放在最后
+	int32 NumDispatched = 0;
+	NumDispatched += ShotFired.Flush();
+	NumDispatched += TargetHit.Flush();
+	NumDispatched += DamageApplied.Flush();
+	NumDispatched += ScoreChanged.Flush();
+	NumDispatched += AmmoChanged.Flush();
+
+	INC_DWORD_STAT_BY(STAT_GameplayEventsDispatched, NumDispatched);
+}
@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Templates/IntegralConstant.h"
+#include "UObject/ObjectKey.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayEventSubsystem.generated.h"
+
+struct FShotFiredEvent
+{
+	TWeakObjectPtr<AActor> Shooter;
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+
+	static constexpr bool bCoalesces = false;
+};
+
+struct FTargetHitEvent
+{
+	TWeakObjectPtr<AActor> Target;
+	TWeakObjectPtr<AActor> Instigator;
+	int32 Points = 1;
+
+	static constexpr bool bCoalesces = false;
+};
+
+struct FDamageAppliedEvent
+{
+	TWeakObjectPtr<AActor> Victim;
+	TWeakObjectPtr<AActor> Causer;
+	float Damage = 0.f;
+
+	static constexpr bool bCoalesces = false;
+};
+
+/** Only the latest score of a frame is delivered */
+struct FScoreChangedEvent
+{
+	int32 Score = 0;
+
+	static constexpr bool bCoalesces = true;
+	FObjectKey GetCoalesceKey() const { return FObjectKey(); }
+};
+
+/** Only the latest counts of a frame are delivered, per owner */
+struct FAmmoChangedEvent
+{
+	TWeakObjectPtr<AActor> Owner;
+	int32 CurrentAmmo = 0;
+	int32 FullAmmo = 0;
+	int32 GrenadeCount = 0;
+
+	static constexpr bool bCoalesces = true;
+	FObjectKey GetCoalesceKey() const { return FObjectKey(Owner.Get()); }
+};
+
+/**
+ * Pending events and subscribers of one event type. Event types with bCoalesces keep only the latest
+ * event per GetCoalesceKey(), the others are queued as posted.
+ */
+template <typename EventType>
+struct TGameplayEventChannel
+{
+	TMulticastDelegate<void(const EventType&)> OnEvent;
+
+	void Post(const EventType& Event)
+	{
+		Post(Event, TIntegralConstant<bool, EventType::bCoalesces>());
+	}
+
+	int32 Flush()
+	{
+		// 分发时收到的新事件进 Pending, 不会打断正在遍历的数组, 两个数组的容量都会被复用
+		Swap(Pending, Dispatching);
+		PendingIndices.Reset();
+		for (const EventType& Event : Dispatching)
+		{
+			OnEvent.Broadcast(Event);
+		}
+		const int32 NumDispatched = Dispatching.Num();
+		Dispatching.Reset();
+		return NumDispatched;
+	}
+
+	void Reset()
+	{
+		OnEvent.Clear();
+		Pending.Empty();
+		Dispatching.Empty();
+		PendingIndices.Empty();
+	}
+
+private:
+	void Post(const EventType& Event, TIntegralConstant<bool, false>)
+	{
+		Pending.Add(Event);
+	}
+
+	void Post(const EventType& Event, TIntegralConstant<bool, true>)
+	{
+		// 按键查找上一条未分发的事件, 不用每次遍历整个队列
+		const FObjectKey Key = Event.GetCoalesceKey();
+		if (const int32* Index = PendingIndices.Find(Key))
+		{
+			Pending[*Index] = Event;
+		}
+		else
+		{
+			PendingIndices.Add(Key, Pending.Add(Event));
+		}
+	}
+
+	TArray<EventType> Pending;
+	TArray<EventType> Dispatching;
+
+	/** Index in Pending per coalesce key, only used by coalescing event types */
+	TMap<FObjectKey, int32> PendingIndices;
+};
+
+/**
+ * Typed gameplay events. Gameplay code posts events, which are coalesced where only the latest value
+ * matters and delivered to subscribers once per frame, so score, HUD and telemetry never reach into
+ * the objects that produced them.
+ *
+ *	Events->On<FTargetHitEvent>().AddUObject(this, &AMyGameStateBase::OnTargetHit);
+ *	Events->Post(FTargetHitEvent{this, Instigator, 1});
+ */
+UCLASS()
+class FPSCPP_API UGameplayEventSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	template <typename EventType>
+	void Post(const EventType& Event)
+	{
+		GetChannel<EventType>().Post(Event);
+	}
+
+	template <typename EventType>
+	TMulticastDelegate<void(const EventType&)>& On()
+	{
+		return GetChannel<EventType>().OnEvent;
+	}
+
+	/** Delivers everything posted so far, events posted by subscribers are delivered in the same flush */
+	void Flush();
+
+	/** Grenades with a burning fuse in this world, written to the Live Grenades stat and Insights counter */
+	void AddLiveGrenades(int32 Delta);
+
+private:
+	template <typename EventType>
+	TGameplayEventChannel<EventType>& GetChannel();
+
+	TGameplayEventChannel<FShotFiredEvent> ShotFired;
+	TGameplayEventChannel<FTargetHitEvent> TargetHit;
+	TGameplayEventChannel<FDamageAppliedEvent> DamageApplied;
+	TGameplayEventChannel<FScoreChangedEvent> ScoreChanged;
+	TGameplayEventChannel<FAmmoChangedEvent> AmmoChanged;
+
+	// 每秒的射击和命中数, 写进Insights计数器
+	int32 ShotsThisSecond = 0;
+	int32 HitsThisSecond = 0;
+	float RateSeconds = 0.f;
+
+	int32 NumLiveGrenades = 0;
+};
+
+template <>
+inline TGameplayEventChannel<FShotFiredEvent>& UGameplayEventSubsystem::GetChannel<FShotFiredEvent>() { return ShotFired; }
+
+template <>
+inline TGameplayEventChannel<FTargetHitEvent>& UGameplayEventSubsystem::GetChannel<FTargetHitEvent>() { return TargetHit; }
+
+template <>
+inline TGameplayEventChannel<FDamageAppliedEvent>& UGameplayEventSubsystem::GetChannel<FDamageAppliedEvent>() { return DamageApplied; }
+
+template <>
+inline TGameplayEventChannel<FScoreChangedEvent>& UGameplayEventSubsystem::GetChannel<FScoreChangedEvent>() { return ScoreChanged; }
+
+template <>
+inline TGameplayEventChannel<FAmmoChangedEvent>& UGameplayEventSubsystem::GetChannel<FAmmoChangedEvent>() { return AmmoChanged; }
@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayTimerSubsystem.h"
+#include "FPSCpp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Gameplay Timers Tick"), STAT_GameplayTimersTick, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Timers Active"), STAT_GameplayTimersActive, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gameplay Timers Expired"), STAT_GameplayTimersExpired, STATGROUP_FPSCpp);
+
+void UGameplayTimerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	NumSlots = FMath::Max(NumSlots, 1);
+	SlotSeconds = FMath::Max(SlotSeconds, KINDA_SMALL_NUMBER);
+	SlotHeads.Init(INDEX_NONE, NumSlots);
+}
+
+void UGameplayTimerSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_GameplayTimersActive, NumActive);
+
+	Timers.Reset();
+	FreeIndices.Reset();
+	SlotHeads.Reset();
+	Expired.Reset();
+	NumActive = 0;
+
+	Super::Deinitialize();
+}
+
+bool UGameplayTimerSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UGameplayTimerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayTimerSubsystem, STATGROUP_Tickables);
+}
+
+FGameplayTimerHandle UGameplayTimerSubsystem::SetTimer(FTimerDelegate Delegate, float Delay)
+{
+	FGameplayTimerHandle Handle;
+	if (!Delegate.IsBound() || SlotHeads.Num() == 0)
+	{
+		return Handle;
+	}
+
+	int32 Index;
+	if (FreeIndices.Num() > 0)
+	{
+		Index = FreeIndices.Pop(false);
+	}
+	else
+	{
+		Index = Timers.AddDefaulted();
+	}
+
+	// 已经累积但还没推进的时间也算进去, 保证不会提前触发
+	const int32 Ticks = FMath::Max(FMath::CeilToInt((Delay + Accumulator) / SlotSeconds), 1);
+
+	FTimer& Timer = Timers[Index];
+	Timer.Delegate = MoveTemp(Delegate);
+	Timer.Rounds = (Ticks - 1) / NumSlots;
+	Timer.bPending = true;
+	Link(Index, (Cursor + Ticks) % NumSlots);
+
+	NumActive++;
+	INC_DWORD_STAT(STAT_GameplayTimersActive);
+
+	Handle.Index = Index;
+	Handle.Serial = Timer.Serial;
+	return Handle;
+}
+
+void UGameplayTimerSubsystem::ClearTimer(FGameplayTimerHandle& Handle)
+{
+	if (FindTimer(Handle))
+	{
+		Unlink(Handle.Index);
+		Free(Handle.Index);
+	}
+	Handle.Invalidate();
+}
+
+bool UGameplayTimerSubsystem::IsTimerActive(const FGameplayTimerHandle& Handle) const
+{
+	return Handle.IsValid() && Timers.IsValidIndex(Handle.Index) && Timers[Handle.Index].Serial == Handle.Serial
+		&& Timers[Handle.Index].bPending;
+}
+
+UGameplayTimerSubsystem::FTimer* UGameplayTimerSubsystem::FindTimer(const FGameplayTimerHandle& Handle)
+{
+	return IsTimerActive(Handle) ? &Timers[Handle.Index] : nullptr;
+}
+
+void UGameplayTimerSubsystem::Link(int32 Index, int32 Slot)
+{
+	FTimer& Timer = Timers[Index];
+	Timer.Slot = Slot;
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = SlotHeads[Slot];
+	if (Timer.Next != INDEX_NONE)
+	{
+		Timers[Timer.Next].Prev = Index;
+	}
+	SlotHeads[Slot] = Index;
+}
+
+void UGameplayTimerSubsystem::Unlink(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+	if (Timer.Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (Timer.Prev != INDEX_NONE)
+	{
+		Timers[Timer.Prev].Next = Timer.Next;
+	}
+	else
+	{
+		SlotHeads[Timer.Slot] = Timer.Next;
+	}
+	if (Timer.Next != INDEX_NONE)
+	{
+		Timers[Timer.Next].Prev = Timer.Prev;
+	}
+
+	Timer.Slot = INDEX_NONE;
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = INDEX_NONE;
+}
+
+void UGameplayTimerSubsystem::Free(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+	Timer.Delegate.Unbind();
+	Timer.bPending = false;
+	Timer.Serial++;
+	FreeIndices.Add(Index);
+
+	NumActive--;
+	DEC_DWORD_STAT(STAT_GameplayTimersActive);
+}
+
+void UGameplayTimerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GameplayTimersTick);
+
+	Accumulator += DeltaTime;
+	while (Accumulator >= SlotSeconds)
+	{
+		Accumulator -= SlotSeconds;
+		Cursor = (Cursor + 1) % NumSlots;
+
+		int32 Index = SlotHeads[Cursor];
+		while (Index != INDEX_NONE)
+		{
+			FTimer& Timer = Timers[Index];
+			const int32 Next = Timer.Next;
+			if (Timer.Rounds > 0)
+			{
+				Timer.Rounds--;
+			}
+			else
+			{
+				Unlink(Index);
+				Expired.Add({Index, Timer.Serial});
+			}
+			Index = Next;
+		}
+	}
+
+	// 先收集再统一触发, 回调里新建或清除计时器不会打乱正在遍历的链表
+	NumExpiredLastTick = 0;
+	for (int32 ExpiredIndex = 0; ExpiredIndex < Expired.Num(); ++ExpiredIndex)
+	{
+		const FGameplayTimerHandle Handle = Expired[ExpiredIndex];
+		if (FTimer* Timer = FindTimer(Handle))
+		{
+			const FTimerDelegate Delegate = MoveTemp(Timer->Delegate);
+			Free(Handle.Index);
+			Delegate.ExecuteIfBound();
+			NumExpiredLastTick++;
+		}
+	}
+	Expired.Reset();
+
+	INC_DWORD_STAT_BY(STAT_GameplayTimersExpired, NumExpiredLastTick);
+}
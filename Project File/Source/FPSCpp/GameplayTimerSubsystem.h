@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayTimerSubsystem.generated.h"
+
+/** Handle to a timer in UGameplayTimerSubsystem, stale handles are detected by the serial */
+struct FGameplayTimerHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; }
+};
+
+/**
+ * Hashed timing wheel for one-shot gameplay timers such as respawns, reloads, cooldowns and fuses.
+ * Timers are bucketed by expiry slot in intrusive lists, so setting and clearing a timer is O(1)
+ * no matter how many are pending, and each tick only walks the slots that elapsed.
+ * Resolution is one slot, expired timers fire together at the end of the tick.
+ */
+UCLASS(config=Game)
+class FPSCPP_API UGameplayTimerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	FGameplayTimerHandle SetTimer(FTimerDelegate Delegate, float Delay);
+
+	template <class UserClass>
+	FGameplayTimerHandle SetTimer(UserClass* Object, typename FTimerDelegate::TUObjectMethodDelegate<UserClass>::FMethodPtr Method, float Delay)
+	{
+		return SetTimer(FTimerDelegate::CreateUObject(Object, Method), Delay);
+	}
+
+	/** Cancels the timer if it is still pending and invalidates the handle */
+	void ClearTimer(FGameplayTimerHandle& Handle);
+
+	bool IsTimerActive(const FGameplayTimerHandle& Handle) const;
+
+	int32 GetNumTimers() const { return NumActive; }
+
+	/** Timers that fired during the last tick */
+	int32 GetNumExpiredLastTick() const { return NumExpiredLastTick; }
+
+	/** Number of buckets, a timer longer than one revolution waits extra rounds in its bucket */
+	UPROPERTY(config)
+	int32 NumSlots = 512;
+
+	/** Duration of a bucket in seconds */
+	UPROPERTY(config)
+	float SlotSeconds = 0.05f;
+
+private:
+	struct FTimer
+	{
+		FTimerDelegate Delegate;
+		int32 Rounds = 0;
+		int32 Slot = INDEX_NONE;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		uint32 Serial = 0;
+		bool bPending = false;
+	};
+
+	FTimer* FindTimer(const FGameplayTimerHandle& Handle);
+
+	void Link(int32 Index, int32 Slot);
+
+	void Unlink(int32 Index);
+
+	void Free(int32 Index);
+
+	TArray<FTimer> Timers;
+	TArray<int32> FreeIndices;
+	TArray<int32> SlotHeads;
+
+	/** Timers unlinked from their slot this tick and waiting to fire */
+	TArray<FGameplayTimerHandle> Expired;
+
+	int32 Cursor = 0;
+	float Accumulator = 0.f;
+	int32 NumActive = 0;
+	int32 NumExpiredLastTick = 0;
+};
@@ -2,11 +2,19 @@
 
 
 #include "Grenade.h"
+#include "FPSCpp.h"
 
-#include "HealthComponent.h"
-#include "Target.h"
+#include "ActorPoolSubsystem.h"
+#include "DamageReceiver.h"
+#include "DamageRegistrySubsystem.h"
+#include "EffectPoolSubsystem.h"
+#include "GameplayEventSubsystem.h"
+#include "HealthSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Kismet/GameplayStatics.h"
 
+DECLARE_CYCLE_STAT(TEXT("Grenade Explode"), STAT_GrenadeExplode, STATGROUP_FPSCpp);
+
 // Sets default values
 AGrenade::AGrenade()
 {
@@ -28,14 +36,80 @@ AGrenade::AGrenade()
 	DamageRange->SetupAttachment(RootComponent);
 	DamageRange->SetRelativeLocation(FVector(0.f));
 	DamageRange->SetSphereRadius(1000.f);
+	//只用来配置爆炸半径, 飞行中不参与碰撞和重叠
+	DamageRange->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	DamageRange->SetGenerateOverlapEvents(false);
+
+	MaxDamage = 150.f;
+	FuseTime = 5.f;
+	LingerDamagePerSecond = 0.f;
+	LingerDuration = 5.f;
+	bSimulatePhysicsOnActivate = false;
+
+	//手雷只在服务器上生成, 位置复制给客户端
+	bReplicates = true;
+	SetReplicatingMovement(true);
 }
 
 // Called when the game starts or when spawned
 void AGrenade::BeginPlay()
 {
 	Super::BeginPlay();
-	
-	GetWorldTimerManager().SetTimer(ExplodeTimerHandle, this, &AGrenade::Explore, 5.f, 0);
+
+	bSimulatePhysicsOnActivate = SphereComponent->IsSimulatingPhysics();
+	StartFuse();
+}
+
+void AGrenade::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetFuseLit(false);
+	Super::EndPlay(EndPlayReason);
+}
+
+void AGrenade::StartFuse()
+{
+	if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+	{
+		Timers->ClearTimer(ExplodeTimerHandle);
+		ExplodeTimerHandle = Timers->SetTimer(this, &AGrenade::Explore, FuseTime);
+		SetFuseLit(true);
+	}
+}
+
+void AGrenade::SetFuseLit(bool bLit)
+{
+	//只统计服务器上的手雷, 客户端的模拟副本不算
+	if (bFuseLit == bLit || (bLit && !HasAuthority()))
+	{
+		return;
+	}
+	bFuseLit = bLit;
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->AddLiveGrenades(bLit ? 1 : -1);
+	}
+}
+
+void AGrenade::OnPooledActivate()
+{
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SphereComponent->SetSimulatePhysics(bSimulatePhysicsOnActivate);
+	StartFuse();
+}
+
+void AGrenade::OnPooledDeactivate()
+{
+	if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+	{
+		Timers->ClearTimer(ExplodeTimerHandle);
+	}
+	SetFuseLit(false);
+	SphereComponent->SetPhysicsLinearVelocity(FVector::ZeroVector);
+	SphereComponent->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+	SphereComponent->SetSimulatePhysics(false);
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
 }
 
 // Called every frame
@@ -52,53 +126,120 @@ void AGrenade::NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveC
 
 void AGrenade::Explore()
 {
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_GrenadeExplode);
+
 	RadialForceComponent->FireImpulse();
-	TArray<AActor*> TargetArray;
-	TSubclassOf<ATarget> TargetClass;
-	DamageRange->GetOverlappingActors(TargetArray,TargetClass);
-	
-	for (auto& Target : TargetArray)
+
+	UWorld* World = GetWorld();
+	const FVector Origin = GetActorLocation();
+	const float Radius = DamageRange->GetScaledSphereRadius();
+
+	//爆炸瞬间做一次球形重叠查询, 取代一直挂在手雷上的重叠检测
+	TArray<FOverlapResult> Overlaps;
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GrenadeExplode), false, this);
+	World->OverlapMultiByObjectType(Overlaps, Origin, FQuat::Identity, ObjectParams,
+	                                FCollisionShape::MakeSphere(Radius), QueryParams);
+
+	//范围内的靶子和带生命组件的pawn统一通过注册表结算, 实例化的靶子按实例分别结算
+	UDamageRegistrySubsystem* Registry = World->GetSubsystem<UDamageRegistrySubsystem>();
+	TArray<FHitResult, TInlineAllocator<32>> Victims;
+	TArray<IDamageReceiver*, TInlineAllocator<32>> Receivers;
+	//一个actor的多个组件只结算一次, 实例化组件按实例去重
+	using FVictimKey = TTuple<const AActor*, const UPrimitiveComponent*, int32>;
+	TSet<FVictimKey, DefaultKeyFuncs<FVictimKey>, TInlineSetAllocator<32>> VictimKeys;
+	for (const FOverlapResult& Overlap : Overlaps)
 	{
-		if (Target->IsA<ATarget>())
+		AActor* Actor = Overlap.GetActor();
+		UInstancedStaticMeshComponent* Instances = Cast<UInstancedStaticMeshComponent>(Overlap.GetComponent());
+		const int32 Item = Instances ? Overlap.ItemIndex : INDEX_NONE;
+		bool bDuplicate = false;
+		VictimKeys.Add(FVictimKey(Actor, Instances, Item), &bDuplicate);
+		if (!Actor || bDuplicate)
+		{
+			continue;
+		}
+		if (IDamageReceiver* Receiver = Registry ? Registry->FindReceiver(Actor) : nullptr)
 		{
-			Cast<ATarget>(Target)->Hitted();
+			FVector VictimLocation = Actor->GetActorLocation();
+			FTransform InstanceTransform;
+			if (Instances && Instances->GetInstanceTransform(Item, InstanceTransform, true))
+			{
+				VictimLocation = InstanceTransform.GetLocation();
+			}
+			FHitResult& Victim = Victims.Emplace_GetRef(Actor, Instances, VictimLocation, FVector::ZeroVector);
+			Victim.Item = Item;
+			Victim.TraceStart = Origin;
+			Victim.TraceEnd = VictimLocation;
+			Receivers.Add(Receiver);
 		}
 	}
-	//带有healthcomp的pawn伤害判定
-	TArray<AActor*> PawnArray;
-	TSubclassOf<APawn> PawnClass;
-	DamageRange->GetOverlappingActors(PawnArray,PawnClass);
-	UE_LOG(LogTemp,Error,TEXT("num:%d"),PawnArray.Num())
-	
-	for (auto& Pawn : PawnArray)
+	FPSCPP_EVENT_LOG(TEXT("Grenade victims %d"), Victims.Num());
+
+	//遮挡检测和伤害衰减先全部算完, 之后统一结算. 场景查询不能在工作线程里同步调用, 留在游戏线程
+	TArray<float, TInlineAllocator<32>> Damages;
+	Damages.SetNumZeroed(Victims.Num());
+	FCollisionQueryParams OcclusionParams(SCENE_QUERY_STAT(GrenadeOcclusion), false, this);
+	for (int32 Index = 0; Index < Victims.Num(); ++Index)
+	{
+		const FVector TargetLocation = Victims[Index].Location;
+
+		OcclusionParams.ClearIgnoredActors();
+		OcclusionParams.AddIgnoredActor(this);
+		OcclusionParams.AddIgnoredActor(Victims[Index].GetActor());
+		if (World->LineTraceTestByChannel(Origin, TargetLocation, ECC_Visibility, OcclusionParams))
+		{
+			continue;
+		}
+
+		const float Distence = (TargetLocation - Origin).Size();
+		Damages[Index] = MaxDamage * FMath::Clamp((Radius - Distence) / Radius, 0.f, 1.f);
+	}
+
+	UGameplayEventSubsystem* Events = World->GetSubsystem<UGameplayEventSubsystem>();
+	for (int32 Index = 0; Index < Victims.Num(); ++Index)
 	{
-		
-		TSubclassOf<class UHealthComponent> HealthClass=UHealthComponent::StaticClass();
-		UActorComponent* GettedComponent;
-		GettedComponent=Pawn->GetComponentByClass(HealthClass);
-		
-		if(GettedComponent)
+		if (Damages[Index] > 0.f)
 		{
-			UHealthComponent* HealthComponent=Cast<UHealthComponent>(GettedComponent);
+			Receivers[Index]->ReceiveDamage(Damages[Index], Victims[Index], this);
+			if (Events)
+			{
+				Events->Post(FDamageAppliedEvent{Victims[Index].GetActor(), this, Damages[Index]});
+			}
+		}
+	}
 
-			float Distence=(Pawn->GetActorLocation()-GetActorLocation()).Size();
-			float Damagevalue=150*(DamageRange->GetScaledSphereRadius()-Distence)/DamageRange->GetScaledSphereRadius();
-			
-			HealthComponent->ChangeHealth(Damagevalue);
+	if (LingerDamagePerSecond > 0.f)
+	{
+		if (UHealthSubsystem* Health = World->GetSubsystem<UHealthSubsystem>())
+		{
+			Health->AddDamageZone(Origin, Radius, LingerDamagePerSecond, LingerDuration, this);
 		}
-		
 	}
 	
 	if(ParticleEmitter)
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(),ParticleEmitter,GetActorLocation());
+		if (UEffectPoolSubsystem* EffectPool = World->GetSubsystem<UEffectPoolSubsystem>())
+		{
+			EffectPool->SpawnAtLocation(ParticleEmitter,Origin);
+		}
 	}
 	if(ExplodeSound)
 	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(),ExplodeSound,GetActorLocation());
+		UGameplayStatics::PlaySoundAtLocation(World,ExplodeSound,Origin);
+	}
+
+	if (UActorPoolSubsystem* ActorPool = World->GetSubsystem<UActorPoolSubsystem>())
+	{
+		ActorPool->Release(this);
+	}
+	else
+	{
+		Destroy();
 	}
-	
-	Destroy();
 }
 
 UStaticMeshComponent* AGrenade::GetStaticMeshComponent()
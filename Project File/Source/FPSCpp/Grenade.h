@@ -3,6 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameplayTimerSubsystem.h"
+#include "PooledActor.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/Actor.h"
 #include "Particles/ParticleEmitter.h"
@@ -10,7 +12,7 @@
 #include "Grenade.generated.h"
 
 UCLASS()
-class FPSCPP_API AGrenade : public AActor
+class FPSCPP_API AGrenade : public AActor, public IPooledActor
 {
 	GENERATED_BODY()
 
@@ -21,6 +23,7 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	// Called every frame
@@ -31,6 +34,9 @@ public:
 	
 	void Explore();
 
+	virtual void OnPooledActivate() override;
+	virtual void OnPooledDeactivate() override;
+
 	UStaticMeshComponent* GetStaticMeshComponent();
 	USphereComponent* GetSphereComponent();
 
@@ -44,13 +50,40 @@ public:
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadWrite)
 	URadialForceComponent* RadialForceComponent;
 
+	/** Explosion radius only, it has no collision and is queried once when the grenade explodes */
 	UPROPERTY(VisibleDefaultsOnly,BlueprintReadWrite)
 	USphereComponent* DamageRange;
+
+	/** Damage at the center of the explosion, falls off linearly to 0 at the DamageRange radius */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Damage)
+	float MaxDamage;
 	
 	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Asset)
 	UParticleSystem* ParticleEmitter;
 
 	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Asset)
 	USoundBase* ExplodeSound;
-	FTimerHandle ExplodeTimerHandle;
+
+	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Damage)
+	float FuseTime;
+
+	/** Damage per second inside the explosion radius after the blast, 0 leaves no lingering zone */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Damage)
+	float LingerDamagePerSecond;
+
+	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category=Damage)
+	float LingerDuration;
+
+	FGameplayTimerHandle ExplodeTimerHandle;
+
+	/** (Re)starts the fuse with FuseTime */
+	void StartFuse();
+
+private:
+	/** Counts an authority grenade in its world's live grenade count while its fuse burns */
+	void SetFuseLit(bool bLit);
+
+	bool bSimulatePhysicsOnActivate;
+
+	bool bFuseLit = false;
 };
@@ -2,19 +2,29 @@
 
 
 #include "HealthComponent.h"
+#include "FPSCpp.h"
+#include "ActorPoolSubsystem.h"
+#include "DamageRegistrySubsystem.h"
+#include "ReplicationStats.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Health Change Health"), STAT_HealthChangeHealth, STATGROUP_FPSCpp);
 
 // Sets default values for this component's properties
 UHealthComponent::UHealthComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	//生命值存放在 UHealthSubsystem 里, 组件本身不需要tick
+	PrimaryComponentTick.bCanEverTick = false;
 
 	FullHealth=100;
 	FullShield=100;
+	bShieldActive=true;
+	ShieldRechargeRate=0;
+	ShieldRechargeDelay=3;
+	bReleaseOwnerOnDeath=true;
 	CurrentHealth=100;
 	CurrentShield=100;
-	bShieldActive=true;
+	SetIsReplicatedByDefault(true);
 }
 
 
@@ -23,30 +33,139 @@ void UHealthComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	if (UHealthSubsystem* Health = GetHealthSubsystem())
+	{
+		HealthHandle = Health->Add(this, FullHealth, FullShield, bShieldActive, ShieldRechargeRate, ShieldRechargeDelay);
+	}
+	//客户端的值来自复制, 不能用初始值覆盖已经复制过来的血量
+	if (GetOwner()->HasAuthority())
+	{
+		SetReplicatedHealth(FullHealth, FullShield);
+	}
+
+	if (UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>())
+	{
+		Registry->Register(GetOwner(), this);
+	}
+}
+
+void UHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>())
+	{
+		Registry->Unregister(GetOwner(), this);
+	}
+
+	if (UHealthSubsystem* Health = GetHealthSubsystem())
+	{
+		Health->Remove(HealthHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+UHealthSubsystem* UHealthComponent::GetHealthSubsystem() const
+{
+	UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UHealthSubsystem>() : nullptr;
+}
+
+float UHealthComponent::GetCurrentHealth() const
+{
+	const UHealthSubsystem* Health = GetHealthSubsystem();
+	return Health && GetOwnerRole() == ROLE_Authority ? Health->GetHealth(HealthHandle) : CurrentHealth;
+}
+
+float UHealthComponent::GetCurrentShield() const
+{
+	const UHealthSubsystem* Health = GetHealthSubsystem();
+	return Health && GetOwnerRole() == ROLE_Authority ? Health->GetShield(HealthHandle) : CurrentShield;
+}
+
+void UHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHealthComponent, CurrentHealth, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHealthComponent, CurrentShield, Params);
+}
+
+void UHealthComponent::SetReplicatedHealth(float NewHealth, float NewShield)
+{
+	if (CurrentHealth != NewHealth)
+	{
+		CurrentHealth = NewHealth;
+		FPSCPP_MARK_PROPERTY_DIRTY(UHealthComponent, CurrentHealth, this);
+	}
+	if (CurrentShield != NewShield)
+	{
+		CurrentShield = NewShield;
+		FPSCPP_MARK_PROPERTY_DIRTY(UHealthComponent, CurrentShield, this);
+	}
 }
 
+bool UHealthComponent::IsAlive() const
+{
+	const UHealthSubsystem* Health = GetHealthSubsystem();
+	return Health && Health->IsAlive(HealthHandle);
+}
 
-// Called every frame
-void UHealthComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UHealthComponent::ChangeHealth(float ChangeCount, AActor* DamageCauser)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_HealthChangeHealth);
+	if (UHealthSubsystem* Health = GetHealthSubsystem())
+	{
+		Health->QueueDamage(HealthHandle, ChangeCount, DamageCauser);
+	}
+}
 
-	// ...
+void UHealthComponent::ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser)
+{
+	ChangeHealth(Damage, DamageCauser);
 }
 
-void UHealthComponent::ChangeHealth(float ChangeCount)
+void UHealthComponent::AddDamageOverTime(float DamagePerSecond, float Duration, AActor* DamageCauser)
 {
-	CurrentHealth-=ChangeCount;
-	if(CurrentHealth<=0)
+	if (UHealthSubsystem* Health = GetHealthSubsystem())
 	{
-		Die();
+		Health->AddEffect(HealthHandle, EHealthEffect::Damage, DamagePerSecond, Duration, DamageCauser);
 	}
 }
 
-void UHealthComponent::Die()
+void UHealthComponent::AddHealOverTime(float HealPerSecond, float Duration)
 {
-	GetOwner()->Destroy();
+	if (UHealthSubsystem* Health = GetHealthSubsystem())
+	{
+		Health->AddEffect(HealthHandle, EHealthEffect::Heal, HealPerSecond, Duration);
+	}
 }
 
+void UHealthComponent::Revive()
+{
+	if (UHealthSubsystem* Health = GetHealthSubsystem())
+	{
+		Health->Revive(HealthHandle);
+	}
+}
+
+void UHealthComponent::Die(AActor* DamageCauser)
+{
+	OnDied.Broadcast(DamageCauser);
+
+	if (!bReleaseOwnerOnDeath)
+	{
+		return;
+	}
+
+	//不在伤害结算中途销毁, 交给对象池在帧末回收
+	if (UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+	{
+		ActorPool->ReleaseDeferred(GetOwner());
+	}
+	else
+	{
+		GetOwner()->Destroy();
+	}
+}
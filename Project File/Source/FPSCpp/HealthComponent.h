@@ -3,12 +3,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "DamageReceiver.h"
+#include "HealthSubsystem.h"
 #include "Components/ActorComponent.h"
 #include "HealthComponent.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHealthComponentDied, AActor*, DamageCauser);
 
+/**
+ * Handle to the owner's entry in UHealthSubsystem. The values below only seed the entry on BeginPlay,
+ * the current health and shield live in the subsystem.
+ */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
-class FPSCPP_API UHealthComponent : public UActorComponent
+class FPSCPP_API UHealthComponent : public UActorComponent, public IDamageReceiver
 {
 	GENERATED_BODY()
 
@@ -18,30 +25,78 @@ public:
 
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
 	float FullHealth;
-	
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
+
+	/** Mirror of the subsystem's health, pushed once per frame on change and replicated to clients */
+	UPROPERTY(VisibleInstanceOnly,BlueprintReadOnly,Replicated,Category=Heaalth)
 	float CurrentHealth;
-	
+
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
 	float FullShield;
 
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
+	UPROPERTY(VisibleInstanceOnly,BlueprintReadOnly,Replicated,Category=Heaalth)
 	float CurrentShield;
 
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
 	bool bShieldActive;
 
+	/** Shield points recharged per second, 0 disables recharge */
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
+	float ShieldRechargeRate;
+
+	/** Seconds without taking damage before the shield starts recharging */
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
+	float ShieldRechargeDelay;
+
+	/** Release the owner at the end of the frame when it dies, off for owners with their own death state */
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
+	bool bReleaseOwnerOnDeath;
+
+	UPROPERTY(BlueprintAssignable,Category=Heaalth)
+	FOnHealthComponentDied OnDied;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+public:
+	UFUNCTION(BlueprintCallable,Category=Heaalth)
+	float GetCurrentHealth() const;
+
+	UFUNCTION(BlueprintCallable,Category=Heaalth)
+	float GetCurrentShield() const;
+
+	UFUNCTION(BlueprintCallable,Category=Heaalth)
+	bool IsAlive() const;
+
+	/** Queues damage, it is applied with the rest of the frame's damage */
+	void ChangeHealth(float ChangeCount, AActor* DamageCauser = nullptr);
+
+	virtual void ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser) override;
+
+	/** Burn, bleed and the like, a negative duration lasts until death */
+	UFUNCTION(BlueprintCallable,Category=Heaalth)
+	void AddDamageOverTime(float DamagePerSecond, float Duration, AActor* DamageCauser);
+
+	UFUNCTION(BlueprintCallable,Category=Heaalth)
+	void AddHealOverTime(float HealPerSecond, float Duration);
+
+	/** Restores full health and shield, e.g. when a pooled owner is reused */
+	UFUNCTION(BlueprintCallable,Category=Heaalth)
+	void Revive();
+
+	/** Called by UHealthSubsystem once health has run out */
+	void Die(AActor* DamageCauser);
+
+	const FHealthHandle& GetHealthHandle() const { return HealthHandle; }
+
+	/** Mirrors the subsystem's values into the replicated properties, called by UHealthSubsystem on change */
+	void SetReplicatedHealth(float NewHealth, float NewShield);
 
-	void ChangeHealth(float ChangeCount);
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-	void Die();
+private:
+	UHealthSubsystem* GetHealthSubsystem() const;
 
-		
+	FHealthHandle HealthHandle;
 };
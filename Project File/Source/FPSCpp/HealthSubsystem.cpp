@@ -0,0 +1,484 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HealthSubsystem.h"
+#include "FPSCpp.h"
+#include "HealthComponent.h"
+#include "DamageRegistrySubsystem.h"
+#include "Engine/World.h"
+#include "WorldCollision.h"
+
+DECLARE_CYCLE_STAT(TEXT("Health Apply Damage"), STAT_HealthApplyDamage, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Health Entities"), STAT_HealthEntities, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Damage Applied"), STAT_HealthDamageApplied, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Deaths"), STAT_HealthDeaths, STATGROUP_FPSCpp);
+DECLARE_CYCLE_STAT(TEXT("Health Step Effects"), STAT_HealthStepEffects, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Health Effects"), STAT_HealthEffects, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Health Damage Zones"), STAT_HealthDamageZones, STATGROUP_FPSCpp);
+
+void UHealthSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UHealthSubsystem::OnWorldPostActorTick);
+}
+
+void UHealthSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	DEC_DWORD_STAT_BY(STAT_HealthEntities, Healths.Num());
+	DEC_DWORD_STAT_BY(STAT_HealthEffects, EffectRates.Num());
+	DEC_DWORD_STAT_BY(STAT_HealthDamageZones, Zones.Num());
+
+	Super::Deinitialize();
+}
+
+void UHealthSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	// 固定频率推进持续效果, 产生的伤害和本帧其它伤害一起结算
+	if (EffectRates.Num() > 0 || Zones.Num() > 0)
+	{
+		const float StepSeconds = 1.f / FMath::Max(EffectTickRate, 1.f);
+		EffectAccumulator += DeltaSeconds;
+
+		int32 Steps = 0;
+		while (EffectAccumulator >= StepSeconds && Steps < MaxEffectStepsPerFrame)
+		{
+			EffectAccumulator -= StepSeconds;
+			StepDamageZones(StepSeconds);
+			StepEffects(StepSeconds);
+			Steps++;
+		}
+		if (Steps == MaxEffectStepsPerFrame)
+		{
+			EffectAccumulator = FMath::Min(EffectAccumulator, StepSeconds);
+		}
+	}
+	else
+	{
+		EffectAccumulator = 0.f;
+	}
+
+	ApplyPendingDamage();
+	PushChanges();
+}
+
+void UHealthSubsystem::MarkChanged(int32 Dense)
+{
+	if (!Changed[Dense])
+	{
+		Changed[Dense] = true;
+
+		FHealthHandle Handle;
+		Handle.Index = DenseToSlot[Dense];
+		Handle.Generation = Slots[Handle.Index].Generation;
+		ChangedHandles.Add(Handle);
+	}
+}
+
+void UHealthSubsystem::PushChanges()
+{
+	for (const FHealthHandle& Handle : ChangedHandles)
+	{
+		const int32 Dense = Resolve(Handle);
+		if (Dense == INDEX_NONE)
+		{
+			continue;
+		}
+		Changed[Dense] = false;
+		if (UHealthComponent* Owner = Owners[Dense].Get())
+		{
+			Owner->SetReplicatedHealth(Healths[Dense], Shields[Dense]);
+		}
+	}
+	ChangedHandles.Reset();
+}
+
+FHealthHandle UHealthSubsystem::Add(UHealthComponent* Owner, float MaxHealth, float MaxShield, bool bShieldActive,
+                                    float ShieldRechargeRate, float ShieldRechargeDelay)
+{
+	int32 SlotIndex;
+	if (FreeSlots.Num() > 0)
+	{
+		SlotIndex = FreeSlots.Pop(false);
+	}
+	else
+	{
+		SlotIndex = Slots.AddDefaulted();
+	}
+
+	const int32 Dense = Healths.Add(MaxHealth);
+	MaxHealths.Add(MaxHealth);
+	Shields.Add(MaxShield);
+	MaxShields.Add(MaxShield);
+	ShieldActive.Add(bShieldActive);
+	Dead.Add(false);
+	ShieldRecharging.Add(false);
+	ShieldRechargeRates.Add(ShieldRechargeRate);
+	ShieldRechargeDelays.Add(ShieldRechargeDelay);
+	ShieldRechargeWaits.Add(0.f);
+	Changed.Add(false);
+	DenseToSlot.Add(SlotIndex);
+	Owners.Add(Owner);
+
+	Slots[SlotIndex].Dense = Dense;
+	INC_DWORD_STAT(STAT_HealthEntities);
+
+	FHealthHandle Handle;
+	Handle.Index = SlotIndex;
+	Handle.Generation = Slots[SlotIndex].Generation;
+	return Handle;
+}
+
+void UHealthSubsystem::Remove(FHealthHandle& Handle)
+{
+	const int32 Dense = Resolve(Handle);
+	if (Dense != INDEX_NONE)
+	{
+		const int32 Last = Healths.Num() - 1;
+		if (Dense != Last)
+		{
+			Slots[DenseToSlot[Last]].Dense = Dense;
+		}
+
+		Healths.RemoveAtSwap(Dense, 1, false);
+		MaxHealths.RemoveAtSwap(Dense, 1, false);
+		Shields.RemoveAtSwap(Dense, 1, false);
+		MaxShields.RemoveAtSwap(Dense, 1, false);
+		ShieldActive.RemoveAtSwap(Dense, 1, false);
+		Dead.RemoveAtSwap(Dense, 1, false);
+		ShieldRecharging.RemoveAtSwap(Dense, 1, false);
+		ShieldRechargeRates.RemoveAtSwap(Dense, 1, false);
+		ShieldRechargeDelays.RemoveAtSwap(Dense, 1, false);
+		ShieldRechargeWaits.RemoveAtSwap(Dense, 1, false);
+		Changed.RemoveAtSwap(Dense, 1, false);
+		DenseToSlot.RemoveAtSwap(Dense, 1, false);
+		Owners.RemoveAtSwap(Dense, 1, false);
+
+		FSlot& Slot = Slots[Handle.Index];
+		Slot.Dense = INDEX_NONE;
+		Slot.Generation++;
+		FreeSlots.Add(Handle.Index);
+		DEC_DWORD_STAT(STAT_HealthEntities);
+	}
+	Handle.Invalidate();
+}
+
+int32 UHealthSubsystem::Resolve(const FHealthHandle& Handle) const
+{
+	if (!Handle.IsValid() || !Slots.IsValidIndex(Handle.Index))
+	{
+		return INDEX_NONE;
+	}
+	const FSlot& Slot = Slots[Handle.Index];
+	return Slot.Generation == Handle.Generation ? Slot.Dense : INDEX_NONE;
+}
+
+void UHealthSubsystem::QueueDamage(const FHealthHandle& Handle, float Damage, AActor* DamageCauser)
+{
+	if (Damage != 0.f && Resolve(Handle) != INDEX_NONE)
+	{
+		PendingDamage.Add({Handle, Damage, DamageCauser});
+	}
+}
+
+void UHealthSubsystem::ApplyPendingDamage()
+{
+	if (PendingDamage.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HealthApplyDamage);
+	INC_DWORD_STAT_BY(STAT_HealthDamageApplied, PendingDamage.Num());
+
+	for (const FPendingDamage& Pending : PendingDamage)
+	{
+		const int32 Dense = Resolve(Pending.Handle);
+		if (Dense == INDEX_NONE || Dead[Dense])
+		{
+			continue;
+		}
+
+		// 负的伤害是治疗, 和治疗效果一样不超过上限, 不碰护盾
+		float Damage = Pending.Damage;
+		if (Damage < 0.f)
+		{
+			Healths[Dense] = FMath::Min(Healths[Dense] - Damage, MaxHealths[Dense]);
+			MarkChanged(Dense);
+			continue;
+		}
+
+		// 护盾先吸收, 剩下的才扣血
+		if (ShieldActive[Dense])
+		{
+			const float Absorbed = FMath::Min(Shields[Dense], Damage);
+			Shields[Dense] -= Absorbed;
+			Damage -= Absorbed;
+		}
+		Healths[Dense] -= Damage;
+		MarkChanged(Dense);
+
+		// 受伤后重新计算护盾回复的等待时间
+		if (ShieldRechargeRates[Dense] > 0.f && MaxShields[Dense] > 0.f)
+		{
+			ShieldRechargeWaits[Dense] = ShieldRechargeDelays[Dense];
+			if (!ShieldRecharging[Dense])
+			{
+				StartShieldRecharge(Dense);
+			}
+		}
+
+		if (Healths[Dense] <= 0.f)
+		{
+			Healths[Dense] = 0.f;
+			Dead[Dense] = true;
+			StopShieldRecharge(Dense);
+			Deaths.Add({Owners[Dense], Pending.DamageCauser});
+		}
+	}
+	PendingDamage.Reset();
+
+	// 整批结算完再通知, 回调里销毁或移除实体不会影响上面的遍历
+	INC_DWORD_STAT_BY(STAT_HealthDeaths, Deaths.Num());
+	for (int32 Index = 0; Index < Deaths.Num(); ++Index)
+	{
+		UHealthComponent* Owner = Deaths[Index].Owner.Get();
+		AActor* DamageCauser = Deaths[Index].DamageCauser.Get();
+		OnDeath.Broadcast(Owner, DamageCauser);
+		if (Owner)
+		{
+			Owner->Die(DamageCauser);
+		}
+	}
+	Deaths.Reset();
+}
+
+bool UHealthSubsystem::IsAlive(const FHealthHandle& Handle) const
+{
+	const int32 Dense = Resolve(Handle);
+	return Dense != INDEX_NONE && !Dead[Dense];
+}
+
+float UHealthSubsystem::GetHealth(const FHealthHandle& Handle) const
+{
+	const int32 Dense = Resolve(Handle);
+	return Dense != INDEX_NONE ? Healths[Dense] : 0.f;
+}
+
+float UHealthSubsystem::GetMaxHealth(const FHealthHandle& Handle) const
+{
+	const int32 Dense = Resolve(Handle);
+	return Dense != INDEX_NONE ? MaxHealths[Dense] : 0.f;
+}
+
+float UHealthSubsystem::GetShield(const FHealthHandle& Handle) const
+{
+	const int32 Dense = Resolve(Handle);
+	return Dense != INDEX_NONE ? Shields[Dense] : 0.f;
+}
+
+float UHealthSubsystem::GetMaxShield(const FHealthHandle& Handle) const
+{
+	const int32 Dense = Resolve(Handle);
+	return Dense != INDEX_NONE ? MaxShields[Dense] : 0.f;
+}
+
+void UHealthSubsystem::SetShieldActive(const FHealthHandle& Handle, bool bActive)
+{
+	const int32 Dense = Resolve(Handle);
+	if (Dense != INDEX_NONE)
+	{
+		ShieldActive[Dense] = bActive;
+	}
+}
+
+void UHealthSubsystem::Revive(const FHealthHandle& Handle)
+{
+	const int32 Dense = Resolve(Handle);
+	if (Dense != INDEX_NONE)
+	{
+		Healths[Dense] = MaxHealths[Dense];
+		Shields[Dense] = MaxShields[Dense];
+		Dead[Dense] = false;
+		StopShieldRecharge(Dense);
+		MarkChanged(Dense);
+	}
+}
+
+void UHealthSubsystem::AddEffect(const FHealthHandle& Handle, EHealthEffect Kind, float RatePerSecond, float Duration,
+                                 AActor* Causer)
+{
+	if (Resolve(Handle) == INDEX_NONE || RatePerSecond <= 0.f || Duration == 0.f)
+	{
+		return;
+	}
+
+	EffectTargets.Add(Handle);
+	EffectKinds.Add(static_cast<uint8>(Kind));
+	EffectRates.Add(RatePerSecond);
+	EffectRemaining.Add(Duration);
+	EffectAmounts.Add(0.f);
+	EffectCausers.Add(Causer);
+	INC_DWORD_STAT(STAT_HealthEffects);
+}
+
+void UHealthSubsystem::StartShieldRecharge(int32 Dense)
+{
+	ShieldRecharging[Dense] = true;
+
+	FHealthHandle Handle;
+	Handle.Index = DenseToSlot[Dense];
+	Handle.Generation = Slots[Handle.Index].Generation;
+	AddEffect(Handle, EHealthEffect::ShieldRecharge, ShieldRechargeRates[Dense], -1.f);
+}
+
+void UHealthSubsystem::StopShieldRecharge(int32 Dense)
+{
+	ShieldRecharging[Dense] = false;
+	ShieldRechargeWaits[Dense] = 0.f;
+
+	// 只在死亡和复活时调用, 直接遍历效果表
+	const int32 Slot = DenseToSlot[Dense];
+	for (int32 Effect = EffectTargets.Num() - 1; Effect >= 0; --Effect)
+	{
+		const FHealthHandle& Target = EffectTargets[Effect];
+		if (Target.Index == Slot && Target.Generation == Slots[Slot].Generation &&
+			EffectKinds[Effect] == static_cast<uint8>(EHealthEffect::ShieldRecharge))
+		{
+			RemoveEffect(Effect);
+		}
+	}
+}
+
+void UHealthSubsystem::RemoveEffect(int32 Effect)
+{
+	EffectTargets.RemoveAtSwap(Effect, 1, false);
+	EffectKinds.RemoveAtSwap(Effect, 1, false);
+	EffectRates.RemoveAtSwap(Effect, 1, false);
+	EffectRemaining.RemoveAtSwap(Effect, 1, false);
+	EffectAmounts.RemoveAtSwap(Effect, 1, false);
+	EffectCausers.RemoveAtSwap(Effect, 1, false);
+	DEC_DWORD_STAT(STAT_HealthEffects);
+}
+
+void UHealthSubsystem::StepEffects(float StepSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HealthStepEffects);
+
+	const int32 NumEffects = EffectRates.Num();
+
+	// 第一遍只做连续数组上的算术, 编译器可以向量化; 剩余时间为负的效果永不结束
+	float* RESTRICT Amounts = EffectAmounts.GetData();
+	float* RESTRICT Remaining = EffectRemaining.GetData();
+	const float* RESTRICT Rates = EffectRates.GetData();
+	for (int32 Effect = 0; Effect < NumEffects; ++Effect)
+	{
+		const float Step = Remaining[Effect] < 0.f ? StepSeconds : FMath::Min(StepSeconds, Remaining[Effect]);
+		Amounts[Effect] = Rates[Effect] * Step;
+		Remaining[Effect] = Remaining[Effect] < 0.f ? Remaining[Effect] : Remaining[Effect] - Step;
+	}
+
+	// 第二遍写回实体, 倒序遍历方便交换删除
+	for (int32 Effect = NumEffects - 1; Effect >= 0; --Effect)
+	{
+		const int32 Dense = Resolve(EffectTargets[Effect]);
+		if (Dense == INDEX_NONE || Dead[Dense])
+		{
+			RemoveEffect(Effect);
+			continue;
+		}
+
+		bool bFinished = EffectRemaining[Effect] == 0.f;
+		switch (static_cast<EHealthEffect>(EffectKinds[Effect]))
+		{
+		case EHealthEffect::Damage:
+			PendingDamage.Add({EffectTargets[Effect], EffectAmounts[Effect], EffectCausers[Effect]});
+			break;
+		case EHealthEffect::Heal:
+			Healths[Dense] = FMath::Min(Healths[Dense] + EffectAmounts[Effect], MaxHealths[Dense]);
+			MarkChanged(Dense);
+			break;
+		case EHealthEffect::ShieldRecharge:
+			if (ShieldRechargeWaits[Dense] > 0.f)
+			{
+				ShieldRechargeWaits[Dense] -= StepSeconds;
+			}
+			else
+			{
+				Shields[Dense] = FMath::Min(Shields[Dense] + EffectAmounts[Effect], MaxShields[Dense]);
+				MarkChanged(Dense);
+				bFinished = Shields[Dense] >= MaxShields[Dense];
+				ShieldRecharging[Dense] = !bFinished;
+			}
+			break;
+		}
+
+		if (bFinished)
+		{
+			RemoveEffect(Effect);
+		}
+	}
+}
+
+void UHealthSubsystem::AddDamageZone(const FVector& Center, float Radius, float DamagePerSecond, float Duration,
+                                     AActor* Causer)
+{
+	if (Radius > 0.f && DamagePerSecond > 0.f && Duration > 0.f)
+	{
+		Zones.Add({Center, Radius, DamagePerSecond, Duration, Causer});
+		INC_DWORD_STAT(STAT_HealthDamageZones);
+	}
+}
+
+void UHealthSubsystem::StepDamageZones(float StepSeconds)
+{
+	UWorld* World = GetWorld();
+	UDamageRegistrySubsystem* Registry = World->GetSubsystem<UDamageRegistrySubsystem>();
+	if (!Registry)
+	{
+		return;
+	}
+
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HealthDamageZone), false);
+
+	TArray<FOverlapResult> Overlaps;
+	TArray<UHealthComponent*, TInlineAllocator<16>> Victims;
+	for (int32 Index = Zones.Num() - 1; Index >= 0; --Index)
+	{
+		FDamageZone& Zone = Zones[Index];
+		const float Step = FMath::Min(StepSeconds, Zone.Remaining);
+		Zone.Remaining -= Step;
+
+		// 每个区域每步只查询一次, 之后进入范围的目标同样会受到伤害
+		Overlaps.Reset();
+		Victims.Reset();
+		World->OverlapMultiByObjectType(Overlaps, Zone.Center, FQuat::Identity, ObjectParams,
+		                                FCollisionShape::MakeSphere(Zone.Radius), QueryParams);
+		for (const FOverlapResult& Overlap : Overlaps)
+		{
+			// 和命中一样走注册表, 只有生命组件会被区域伤害, 靶子之类的接收者不算
+			IDamageReceiver* Receiver = Registry->FindReceiver(Overlap.GetActor());
+			UHealthComponent* Victim = Receiver ? Cast<UHealthComponent>(Receiver->_getUObject()) : nullptr;
+			if (Victim && !Victims.Contains(Victim))
+			{
+				Victims.Add(Victim);
+				QueueDamage(Victim->GetHealthHandle(), Zone.DamagePerSecond * Step, Zone.Causer.Get());
+			}
+		}
+
+		if (Zone.Remaining <= 0.f)
+		{
+			Zones.RemoveAtSwap(Index, 1, false);
+			DEC_DWORD_STAT(STAT_HealthDamageZones);
+		}
+	}
+}
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HealthSubsystem.generated.h"
+
+class UHealthComponent;
+
+/** Handle to an entity in UHealthSubsystem, a released entity's handles go stale through the generation */
+struct FHealthHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; }
+};
+
+UENUM(BlueprintType)
+enum class EHealthEffect : uint8
+{
+	/** Damage over time, absorbed by shields like any other damage */
+	Damage,
+	/** Health regeneration, capped at max health */
+	Heal,
+	/** Shield recharge, waits for the entity's recharge delay after each hit and ends once the shield is full */
+	ShieldRecharge
+};
+
+/**
+ * Health and shield of every damageable entity, packed as parallel arrays. Damage is queued during
+ * the frame and applied in one pass at the end of it, shields absorb damage before health, and
+ * entities whose health runs out are reported once through OnDeath.
+ * Damage and heal over time, shield recharge and lingering damage zones are effect records stepped at
+ * EffectTickRate, so their cost follows the number of running effects rather than the number of actors.
+ */
+UCLASS(config=Game)
+class FPSCPP_API UHealthSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	FHealthHandle Add(UHealthComponent* Owner, float MaxHealth, float MaxShield, bool bShieldActive,
+	                  float ShieldRechargeRate = 0.f, float ShieldRechargeDelay = 0.f);
+
+	void Remove(FHealthHandle& Handle);
+
+	/** Damage is applied when the frame's batch is processed, not immediately. Negative damage heals up to max health */
+	void QueueDamage(const FHealthHandle& Handle, float Damage, AActor* DamageCauser);
+
+	/** Applies every queued damage, called automatically at the end of each world tick */
+	void ApplyPendingDamage();
+
+	bool IsAlive(const FHealthHandle& Handle) const;
+	float GetHealth(const FHealthHandle& Handle) const;
+	float GetMaxHealth(const FHealthHandle& Handle) const;
+	float GetShield(const FHealthHandle& Handle) const;
+	float GetMaxShield(const FHealthHandle& Handle) const;
+
+	void SetShieldActive(const FHealthHandle& Handle, bool bActive);
+
+	/** Restores health and shield to their maximum, e.g. on respawn */
+	void Revive(const FHealthHandle& Handle);
+
+	int32 GetNumEntities() const { return Healths.Num(); }
+
+	/** Adds an effect changing health or shield by RatePerSecond for Duration seconds, a negative duration never ends */
+	void AddEffect(const FHealthHandle& Handle, EHealthEffect Kind, float RatePerSecond, float Duration,
+	               AActor* Causer = nullptr);
+
+	/** Damages every health entity inside the sphere for Duration seconds, including ones that walk in later */
+	void AddDamageZone(const FVector& Center, float Radius, float DamagePerSecond, float Duration, AActor* Causer);
+
+	int32 GetNumEffects() const { return EffectRates.Num(); }
+
+	int32 GetNumDamageZones() const { return Zones.Num(); }
+
+	/** Effect steps per second */
+	UPROPERTY(config)
+	float EffectTickRate = 10.f;
+
+	/** Steps run at most per frame after a hitch, the rest of the backlog is dropped */
+	UPROPERTY(config)
+	int32 MaxEffectStepsPerFrame = 4;
+
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnHealthDepleted, UHealthComponent* /*Owner*/, AActor* /*DamageCauser*/);
+	FOnHealthDepleted OnDeath;
+
+private:
+	struct FSlot
+	{
+		int32 Dense = INDEX_NONE;
+		uint32 Generation = 0;
+	};
+
+	struct FPendingDamage
+	{
+		FHealthHandle Handle;
+		float Damage;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+
+	int32 Resolve(const FHealthHandle& Handle) const;
+
+	void StepEffects(float StepSeconds);
+
+	void StepDamageZones(float StepSeconds);
+
+	void RemoveEffect(int32 Effect);
+
+	void StartShieldRecharge(int32 Dense);
+
+	/** Drops a running recharge and its wait, so the next hit after a revive starts a fresh one */
+	void StopShieldRecharge(int32 Dense);
+
+	void MarkChanged(int32 Dense);
+
+	/** Copies changed values into the owners' replicated properties */
+	void PushChanges();
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	// 稀疏槽位 -> 紧凑下标, 删除时交换到末尾, 数组始终连续
+	TArray<FSlot> Slots;
+	TArray<int32> FreeSlots;
+
+	TArray<float> Healths;
+	TArray<float> MaxHealths;
+	TArray<float> Shields;
+	TArray<float> MaxShields;
+	TArray<uint8> ShieldActive;
+	TArray<uint8> Dead;
+	TArray<uint8> ShieldRecharging;
+	TArray<float> ShieldRechargeRates;
+	TArray<float> ShieldRechargeDelays;
+	TArray<float> ShieldRechargeWaits;
+	TArray<uint8> Changed;
+	TArray<int32> DenseToSlot;
+	TArray<TWeakObjectPtr<UHealthComponent>> Owners;
+
+	TArray<FPendingDamage> PendingDamage;
+
+	/** Entities whose health or shield changed this frame, pushed to replication once at the end of it */
+	TArray<FHealthHandle> ChangedHandles;
+
+	struct FDeath
+	{
+		TWeakObjectPtr<UHealthComponent> Owner;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+	TArray<FDeath> Deaths;
+
+	// 效果记录同样按列存放
+	TArray<FHealthHandle> EffectTargets;
+	TArray<uint8> EffectKinds;
+	TArray<float> EffectRates;
+	TArray<float> EffectRemaining;
+	TArray<float> EffectAmounts;
+	TArray<TWeakObjectPtr<AActor>> EffectCausers;
+
+	struct FDamageZone
+	{
+		FVector Center;
+		float Radius;
+		float DamagePerSecond;
+		float Remaining;
+		TWeakObjectPtr<AActor> Causer;
+	};
+	TArray<FDamageZone> Zones;
+
+	float EffectAccumulator = 0.f;
+
+	FDelegateHandle PostActorTickHandle;
+};
@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "HealthSystem.generated.h"
 
+class UHealthComponent;
+
 UCLASS()
 class FPSCPP_API AHealthSystem : public AActor
 {
@@ -15,27 +17,7 @@ public:
 	// Sets default values for this actor's properties
 	AHealthSystem();
 
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
-	float FullHealth;
-	
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
-	float CurrentHealth;
-	
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
-	float FullShield;
-
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
-	float CurrentShield;
-
-	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category=Heaalth)
-	bool bShieldActive;
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
+	/** Health and shield are stored in UHealthSubsystem through this component */
+	UPROPERTY(VisibleAnywhere,BlueprintReadOnly,Category=Heaalth)
+	UHealthComponent* HealthComponent;
 };
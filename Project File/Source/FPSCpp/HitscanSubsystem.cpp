@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanSubsystem.h"
+#include "FPSCpp.h"
+#include "FPSCppCharacter.h"
+#include "LagCompensationSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan Resolve"), STAT_HitscanResolve, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Shots Resolved"), STAT_HitscanShotsResolved, STATGROUP_FPSCpp);
+
+static TAutoConsoleVariable<int32> CVarHitscanAsync(
+	TEXT("fpscpp.Hitscan.Async"),
+	1,
+	TEXT("1: trace shots in the async query batch and resolve them next frame.\n")
+	TEXT("0: blocking trace per shot, resolved immediately."),
+	ECVF_Default);
+
+void UHitscanSubsystem::Deinitialize()
+{
+	InFlightShots.Reset();
+	Super::Deinitialize();
+}
+
+bool UHitscanSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && InFlightShots.Num() > 0;
+}
+
+TStatId UHitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanSubsystem, STATGROUP_Tickables);
+}
+
+void UHitscanSubsystem::QueueShot(AFPSCppCharacter* Shooter, const FVector& Start, const FVector& End,
+                                  float ClientTime, uint8 ShotId)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	FHitscanShot Shot;
+	Shot.Shooter = Shooter;
+	Shot.Start = Start;
+	Shot.End = End;
+	Shot.IssueFrame = GFrameCounter;
+	Shot.RewindTime = -1.f;
+	Shot.ShotId = ShotId;
+
+	// 回溯的角色只按历史姿势判定, 世界射线忽略它们当前的位置, 其余角色照常按当前碰撞判定
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(HitscanShot), false, Shooter);
+	ULagCompensationSubsystem* LagCompensation = World->GetSubsystem<ULagCompensationSubsystem>();
+	if (ClientTime >= 0.f && LagCompensation && LagCompensation->IsEnabled())
+	{
+		Shot.RewindTime = LagCompensation->ClampRewindTime(ClientTime);
+		LagCompensation->SelectRewound(Shooter, Start, End, Shot.RewindTime, Shot.RewoundCharacters, Params);
+	}
+
+	if (CVarHitscanAsync.GetValueOnGameThread() == 0)
+	{
+		FHitResult HitResult;
+		World->LineTraceSingleByChannel(HitResult, Start, End, ECollisionChannel::ECC_Visibility, Params);
+		ResolveShot(Shot, HitResult);
+		return;
+	}
+
+	Shot.TraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End,
+	                                                  ECollisionChannel::ECC_Visibility, Params);
+	InFlightShots.Add(Shot);
+}
+
+void UHitscanSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitscanResolve);
+
+	UWorld* World = GetWorld();
+	int32 NumResolved = 0;
+	int32 WriteIndex = 0;
+
+	for (int32 ReadIndex = 0; ReadIndex < InFlightShots.Num(); ++ReadIndex)
+	{
+		const FHitscanShot Shot = InFlightShots[ReadIndex];
+
+		// 本帧发出的射线要到下一帧才有结果
+		if (Shot.IssueFrame == GFrameCounter)
+		{
+			InFlightShots[WriteIndex++] = Shot;
+			continue;
+		}
+
+		FHitResult HitResult;
+		FTraceDatum TraceDatum;
+		if (World->QueryTraceData(Shot.TraceHandle, TraceDatum))
+		{
+			if (TraceDatum.OutHits.Num() > 0)
+			{
+				HitResult = TraceDatum.OutHits[0];
+			}
+		}
+		else
+		{
+			// The batch this shot belonged to is gone (e.g. a long hitch), trace it now instead of dropping it
+			FCollisionQueryParams Params(SCENE_QUERY_STAT(HitscanShot), false, Shot.Shooter.Get());
+			for (const TWeakObjectPtr<AFPSCppCharacter>& Rewound : Shot.RewoundCharacters)
+			{
+				Params.AddIgnoredActor(Rewound.Get());
+			}
+			World->LineTraceSingleByChannel(HitResult, Shot.Start, Shot.End, ECollisionChannel::ECC_Visibility, Params);
+		}
+
+		ResolveShot(Shot, HitResult);
+		NumResolved++;
+	}
+
+	InFlightShots.SetNum(WriteIndex, false);
+	INC_DWORD_STAT_BY(STAT_HitscanShotsResolved, NumResolved);
+}
+
+void UHitscanSubsystem::ResolveShot(const FHitscanShot& Shot, FHitResult HitResult) const
+{
+	if (Shot.RewoundCharacters.Num() > 0)
+	{
+		// 回溯姿势上的命中比世界命中更近时取回溯结果
+		FHitResult RewoundHit;
+		ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+		if (LagCompensation->TraceRewound(Shot.RewoundCharacters, Shot.Start, Shot.End, Shot.RewindTime, RewoundHit)
+			&& (!HitResult.bBlockingHit || RewoundHit.Distance < HitResult.Distance))
+		{
+			HitResult = RewoundHit;
+		}
+	}
+
+	if (AFPSCppCharacter* Shooter = Shot.Shooter.Get())
+	{
+		Shooter->ResolveShot(HitResult, Shot.Start, Shot.End, Shot.ShotId);
+	}
+}
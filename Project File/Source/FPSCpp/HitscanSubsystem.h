@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "LagCompensationSubsystem.h"
+#include "WorldCollision.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HitscanSubsystem.generated.h"
+
+class AFPSCppCharacter;
+
+struct FHitscanShot
+{
+	TWeakObjectPtr<AFPSCppCharacter> Shooter;
+	FVector Start;
+	FVector End;
+	FTraceHandle TraceHandle;
+	uint64 IssueFrame;
+	/** Server time the characters are rewound to, negative for shots traced against the current poses */
+	float RewindTime;
+	/** Characters traced at RewindTime and ignored by the world trace */
+	FLagRewoundCharacters RewoundCharacters;
+	uint8 ShotId;
+};
+
+/**
+ * Collects every hitscan shot fired in a frame, traces them in the async physics query batch
+ * and resolves them together on the next frame.
+ * fpscpp.Hitscan.Async 0 switches back to a blocking trace per shot for A/B comparisons.
+ */
+UCLASS()
+class FPSCPP_API UHitscanSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	/** ClientTime is the server time the shooting client saw, negative when the shot needs no lag compensation */
+	void QueueShot(AFPSCppCharacter* Shooter, const FVector& Start, const FVector& End, float ClientTime = -1.f,
+	               uint8 ShotId = 0);
+
+private:
+	void ResolveShot(const FHitscanShot& Shot, FHitResult HitResult) const;
+
+	TArray<FHitscanShot> InFlightShots;
+};
@@ -0,0 +1,319 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LagCompensationSubsystem.h"
+#include "FPSCpp.h"
+#include "FPSCppCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "CollisionQueryParams.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_LagCompensationRecord, STATGROUP_FPSCpp);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Rewind"), STAT_LagCompensationRewind, STATGROUP_FPSCpp);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lag Compensated Characters"), STAT_LagCompensatedCharacters, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensation Rewinds"), STAT_LagCompensationRewinds, STATGROUP_FPSCpp);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensation Candidates Dropped"), STAT_LagCompensationDropped, STATGROUP_FPSCpp);
+
+static TAutoConsoleVariable<int32> CVarLagCompensationEnable(
+	TEXT("fpscpp.LagCompensation.Enable"),
+	1,
+	TEXT("1: trace client shots against character poses rewound to the client's time.\n")
+	TEXT("0: trace client shots against the current poses."),
+	ECVF_Default);
+
+void ULagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	HistorySize = FMath::Max(HistorySize, 2);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(
+		this, &ULagCompensationSubsystem::OnWorldPostActorTick);
+}
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	DEC_DWORD_STAT_BY(STAT_LagCompensatedCharacters, Pawns.Num());
+	Pawns.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULagCompensationSubsystem::Register(AFPSCppCharacter* Character)
+{
+	if (!Character || Pawns.ContainsByPredicate([Character](const FLagCompensatedPawn& Pawn)
+	{
+		return Pawn.Character == Character;
+	}))
+	{
+		return;
+	}
+
+	// 专用服务器上没人看得到网格体, 默认只tick姿势不刷新骨骼, 记录下来的骨骼位置会停在旧的一帧
+	Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	FLagCompensatedPawn& Pawn = Pawns.AddDefaulted_GetRef();
+	Pawn.Character = Character;
+	for (const FLagHitbox& Hitbox : Hitboxes)
+	{
+		Pawn.BoneIndices.Add(Character->GetMesh()->GetBoneIndex(Hitbox.Bone));
+	}
+	Pawn.Times.SetNumZeroed(HistorySize);
+	Pawn.RootLocations.SetNumZeroed(HistorySize);
+	Pawn.Bones.SetNum(HistorySize * Hitboxes.Num());
+	INC_DWORD_STAT(STAT_LagCompensatedCharacters);
+}
+
+void ULagCompensationSubsystem::Unregister(AFPSCppCharacter* Character)
+{
+	const int32 Index = Pawns.IndexOfByPredicate([Character](const FLagCompensatedPawn& Pawn)
+	{
+		return Pawn.Character == Character;
+	});
+	if (Index != INDEX_NONE)
+	{
+		Pawns.RemoveAtSwap(Index);
+		DEC_DWORD_STAT(STAT_LagCompensatedCharacters);
+	}
+}
+
+void ULagCompensationSubsystem::ResetHistory(AFPSCppCharacter* Character)
+{
+	for (FLagCompensatedPawn& Pawn : Pawns)
+	{
+		if (Pawn.Character == Character)
+		{
+			Pawn.Newest = INDEX_NONE;
+			Pawn.NumSamples = 0;
+		}
+	}
+}
+
+bool ULagCompensationSubsystem::IsEnabled() const
+{
+	return CVarLagCompensationEnable.GetValueOnGameThread() != 0 && Pawns.Num() > 0 && Hitboxes.Num() > 0;
+}
+
+float ULagCompensationSubsystem::ClampRewindTime(float ClientTime) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(ClientTime, Now - MaxRewindSeconds, Now);
+}
+
+void ULagCompensationSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || World->GetNetMode() == NM_Client || Pawns.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRecord);
+
+	const float Now = World->GetTimeSeconds();
+	for (int32 Index = Pawns.Num() - 1; Index >= 0; --Index)
+	{
+		FLagCompensatedPawn& Pawn = Pawns[Index];
+		const AFPSCppCharacter* Character = Pawn.Character.Get();
+		if (!Character)
+		{
+			Pawns.RemoveAtSwap(Index);
+			DEC_DWORD_STAT(STAT_LagCompensatedCharacters);
+			continue;
+		}
+
+		// 池里的pawn和尸体不需要记录
+		if (!Character->IsHidden() && !Character->bIsDead)
+		{
+			Record(Pawn, Now);
+		}
+	}
+}
+
+void ULagCompensationSubsystem::Record(FLagCompensatedPawn& Pawn, float Now)
+{
+	const USkeletalMeshComponent* Mesh = Pawn.Character->GetMesh();
+	const FVector Root = Pawn.Character->GetActorLocation();
+	const int32 NumHitboxes = Pawn.BoneIndices.Num();
+
+	Pawn.Newest = (Pawn.Newest + 1) % HistorySize;
+	Pawn.NumSamples = FMath::Min(Pawn.NumSamples + 1, HistorySize);
+	Pawn.Times[Pawn.Newest] = Now;
+	Pawn.RootLocations[Pawn.Newest] = Root;
+
+	FLagBoneSample* Samples = &Pawn.Bones[Pawn.Newest * NumHitboxes];
+	for (int32 Hitbox = 0; Hitbox < NumHitboxes; ++Hitbox)
+	{
+		const int32 BoneIndex = Pawn.BoneIndices[Hitbox];
+		const FVector Offset = BoneIndex != INDEX_NONE
+			                       ? (Mesh->GetBoneTransform(BoneIndex).GetLocation() - Root) * HitboxQuantizeScale
+			                       : FVector::ZeroVector;
+		Samples[Hitbox].X = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Offset.X), MIN_int16, MAX_int16));
+		Samples[Hitbox].Y = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Offset.Y), MIN_int16, MAX_int16));
+		Samples[Hitbox].Z = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Offset.Z), MIN_int16, MAX_int16));
+	}
+}
+
+bool ULagCompensationSubsystem::FindSamples(const FLagCompensatedPawn& Pawn, float Time, int32& OutOlder,
+                                            int32& OutNewer, float& OutAlpha) const
+{
+	if (Pawn.NumSamples == 0)
+	{
+		return false;
+	}
+
+	// 从最新往回找第一个不晚于Time的样本, 比记录还早的时间就用最旧的一帧
+	OutNewer = Pawn.Newest;
+	OutOlder = Pawn.Newest;
+	for (int32 Age = 0; Age < Pawn.NumSamples; ++Age)
+	{
+		const int32 Sample = (Pawn.Newest - Age + HistorySize) % HistorySize;
+		OutOlder = Sample;
+		if (Pawn.Times[Sample] <= Time)
+		{
+			break;
+		}
+		OutNewer = Sample;
+	}
+
+	const float Span = Pawn.Times[OutNewer] - Pawn.Times[OutOlder];
+	OutAlpha = Span > KINDA_SMALL_NUMBER ? FMath::Clamp((Time - Pawn.Times[OutOlder]) / Span, 0.f, 1.f) : 0.f;
+	return true;
+}
+
+FVector ULagCompensationSubsystem::GetBoneLocation(const FLagCompensatedPawn& Pawn, int32 Sample, int32 Hitbox) const
+{
+	const FLagBoneSample& Bone = Pawn.Bones[Sample * Pawn.BoneIndices.Num() + Hitbox];
+	return Pawn.RootLocations[Sample] + FVector(Bone.X, Bone.Y, Bone.Z) / HitboxQuantizeScale;
+}
+
+void ULagCompensationSubsystem::SelectRewound(const AActor* Shooter, const FVector& Start, const FVector& End,
+                                              float Time, FLagRewoundCharacters& OutCharacters,
+                                              FCollisionQueryParams& Params) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRewind);
+
+	const FVector Delta = End - Start;
+	const float Length = Delta.Size();
+	if (Length <= KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+	const FVector Direction = Delta / Length;
+
+	struct FCandidate
+	{
+		AFPSCppCharacter* Character;
+		float Along;
+	};
+	TArray<FCandidate, TInlineAllocator<16>> Candidates;
+
+	for (const FLagCompensatedPawn& Pawn : Pawns)
+	{
+		AFPSCppCharacter* Character = Pawn.Character.Get();
+		if (!Character || Character == Shooter)
+		{
+			continue;
+		}
+
+		// 尸体和池里的pawn不再记录, 最后一帧的姿势不能留下能挡子弹的碰撞盒
+		if (Character->bIsDead || Character->IsHidden() || Pawn.NumSamples == 0 ||
+			Pawn.Times[Pawn.Newest] < Time - MaxRewindSeconds)
+		{
+			continue;
+		}
+
+		int32 Older, Newer;
+		float Alpha;
+		if (!FindSamples(Pawn, Time, Older, Newer, Alpha))
+		{
+			continue;
+		}
+
+		const FVector Root = FMath::Lerp(Pawn.RootLocations[Older], Pawn.RootLocations[Newer], Alpha);
+		if (FMath::PointDistToSegmentSquared(Root, Start, End) <= FMath::Square(CandidateRadius))
+		{
+			Candidates.Add({Character, (Root - Start) | Direction});
+		}
+	}
+
+	// 超出上限的角色不回溯, 世界射线照常打它们当前的碰撞
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.Along < B.Along; });
+	const int32 NumRewinds = FMath::Min(Candidates.Num(), MaxRewindsPerShot);
+	INC_DWORD_STAT_BY(STAT_LagCompensationRewinds, NumRewinds);
+	INC_DWORD_STAT_BY(STAT_LagCompensationDropped, Candidates.Num() - NumRewinds);
+
+	for (int32 Index = 0; Index < NumRewinds; ++Index)
+	{
+		OutCharacters.Add(Candidates[Index].Character);
+		Params.AddIgnoredActor(Candidates[Index].Character);
+	}
+}
+
+bool ULagCompensationSubsystem::TraceRewound(const FLagRewoundCharacters& Characters, const FVector& Start,
+                                             const FVector& End, float Time, FHitResult& OutHit) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRewind);
+
+	const FVector Delta = End - Start;
+	const float Length = Delta.Size();
+	if (Length <= KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+	const FVector Direction = Delta / Length;
+
+	float BestDistance = Length;
+	bool bHit = false;
+	for (const TWeakObjectPtr<AFPSCppCharacter>& Rewound : Characters)
+	{
+		const FLagCompensatedPawn* Pawn = Pawns.FindByPredicate([&Rewound](const FLagCompensatedPawn& Other)
+		{
+			return Other.Character == Rewound;
+		});
+		int32 Older, Newer;
+		float Alpha;
+		if (!Pawn || !Rewound.IsValid() || !FindSamples(*Pawn, Time, Older, Newer, Alpha))
+		{
+			continue;
+		}
+
+		for (int32 Hitbox = 0; Hitbox < Pawn->BoneIndices.Num(); ++Hitbox)
+		{
+			if (Pawn->BoneIndices[Hitbox] == INDEX_NONE)
+			{
+				continue;
+			}
+
+			const FVector Center = FMath::Lerp(GetBoneLocation(*Pawn, Older, Hitbox),
+			                                   GetBoneLocation(*Pawn, Newer, Hitbox), Alpha);
+			const float Radius = Hitboxes[Hitbox].Radius;
+
+			// 射线与球求交, 取进入点
+			const FVector ToStart = Start - Center;
+			const float B = ToStart | Direction;
+			const float C = ToStart.SizeSquared() - Radius * Radius;
+			const float Discriminant = B * B - C;
+			if (Discriminant < 0.f || (C > 0.f && B > 0.f))
+			{
+				continue;
+			}
+			const float Distance = FMath::Max(-B - FMath::Sqrt(Discriminant), 0.f);
+			if (Distance >= BestDistance)
+			{
+				continue;
+			}
+
+			const FVector ImpactPoint = Start + Direction * Distance;
+			AFPSCppCharacter* Character = Rewound.Get();
+			OutHit = FHitResult(Character, Character->GetMesh(), ImpactPoint, (ImpactPoint - Center).GetSafeNormal());
+			OutHit.bBlockingHit = true;
+			OutHit.BoneName = Hitboxes[Hitbox].Bone;
+			OutHit.Distance = Distance;
+			OutHit.Time = Distance / Length;
+			OutHit.TraceStart = Start;
+			OutHit.TraceEnd = End;
+			BestDistance = Distance;
+			bHit = true;
+		}
+	}
+	return bHit;
+}
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class AFPSCppCharacter;
+
+/** A sphere around one bone of Mesh1P, shots are tested against these instead of the physics asset */
+USTRUCT()
+struct FLagHitbox
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Bone;
+
+	UPROPERTY()
+	float Radius = 15.f;
+};
+
+/** Bone position relative to the pawn's root, in 1/HitboxQuantizeScale cm */
+struct FLagBoneSample
+{
+	int16 X = 0;
+	int16 Y = 0;
+	int16 Z = 0;
+};
+
+/** History of one character, every array is sized once at registration and reused as a ring */
+struct FLagCompensatedPawn
+{
+	TWeakObjectPtr<AFPSCppCharacter> Character;
+
+	/** Mesh1P bone index per hitbox, INDEX_NONE if the mesh has no such bone */
+	TArray<int32> BoneIndices;
+
+	TArray<float> Times;
+	TArray<FVector> RootLocations;
+
+	/** HistorySize * hitbox count, frame major */
+	TArray<FLagBoneSample> Bones;
+
+	int32 Newest = INDEX_NONE;
+	int32 NumSamples = 0;
+};
+
+/** Characters rewound for one shot */
+typedef TArray<TWeakObjectPtr<AFPSCppCharacter>, TInlineAllocator<4>> FLagRewoundCharacters;
+
+/**
+ * Server side lag compensation. Records the hitbox bones of every character's Mesh1P at the end of
+ * each frame, and traces shots against the poses interpolated at the time the shooting client saw.
+ * Only candidates whose root passes near the shot are rewound, capped at MaxRewindsPerShot. The world
+ * trace ignores just those, every other character is still hit on its current collision.
+ * A rewound character can only be hit inside its Hitboxes spheres, misses between them are not
+ * checked against the physics asset.
+ * fpscpp.LagCompensation.Enable 0 traces shots against the current poses for A/B comparisons.
+ */
+UCLASS(config=Game)
+class FPSCPP_API ULagCompensationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void Register(AFPSCppCharacter* Character);
+
+	void Unregister(AFPSCppCharacter* Character);
+
+	/** Drops the recorded history, e.g. after a teleport or respawn */
+	void ResetHistory(AFPSCppCharacter* Character);
+
+	bool IsEnabled() const;
+
+	/** Clamps a client timestamp to the recorded window */
+	float ClampRewindTime(float ClientTime) const;
+
+	/**
+	 * Picks the characters to rewind for a shot at Time, Shooter is skipped. They are added to Params so the
+	 * world trace does not also hit their current poses.
+	 */
+	void SelectRewound(const AActor* Shooter, const FVector& Start, const FVector& End, float Time,
+	                   FLagRewoundCharacters& OutCharacters, FCollisionQueryParams& Params) const;
+
+	/** Closest hitbox hit along Start-End with Characters rewound to Time */
+	bool TraceRewound(const FLagRewoundCharacters& Characters, const FVector& Start, const FVector& End, float Time,
+	                  FHitResult& OutHit) const;
+
+	int32 GetNumCharacters() const { return Pawns.Num(); }
+
+	/** Frames kept per character */
+	UPROPERTY(config)
+	int32 HistorySize = 32;
+
+	/** Oldest pose a client may rewind to */
+	UPROPERTY(config)
+	float MaxRewindSeconds = 0.25f;
+
+	/** Characters rewound and tested per shot, the nearest along the shot win */
+	UPROPERTY(config)
+	int32 MaxRewindsPerShot = 4;
+
+	/** A character is a candidate when its root is this close to the shot */
+	UPROPERTY(config)
+	float CandidateRadius = 150.f;
+
+	UPROPERTY(config)
+	float HitboxQuantizeScale = 4.f;
+
+	UPROPERTY(config)
+	TArray<FLagHitbox> Hitboxes;
+
+private:
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void Record(FLagCompensatedPawn& Pawn, float Now);
+
+	/** Root and bone sample indices bracketing Time, with the blend between them */
+	bool FindSamples(const FLagCompensatedPawn& Pawn, float Time, int32& OutOlder, int32& OutNewer,
+	                 float& OutAlpha) const;
+
+	FVector GetBoneLocation(const FLagCompensatedPawn& Pawn, int32 Sample, int32 Hitbox) const;
+
+	TArray<FLagCompensatedPawn> Pawns;
+
+	FDelegateHandle PostActorTickHandle;
+};
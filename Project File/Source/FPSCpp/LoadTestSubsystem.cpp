@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LoadTestSubsystem.h"
+#include "ActorPoolSubsystem.h"
+#include "FPSCppBotController.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/FileManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+
+void FLoadTestTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+                                        const FGraphEventRef& MyCompletionGraphEvent)
+{
+	*Stamp = FPlatformTime::Seconds();
+}
+
+void ULoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FString StagesString;
+	if (!GetWorld()->IsGameWorld() || !FParse::Value(FCommandLine::Get(), TEXT("FPSCppLoadTest="), StagesString, false))
+	{
+		return;
+	}
+
+	TArray<FString> Parts;
+	StagesString.ParseIntoArray(Parts, TEXT(","));
+	for (const FString& Part : Parts)
+	{
+		const int32 NumBots = FCString::Atoi(*Part);
+		if (NumBots > 0)
+		{
+			Stages.Add(NumBots);
+		}
+	}
+	if (Stages.Num() == 0)
+	{
+		return;
+	}
+
+	CsvPath = FPaths::ProfilingDir() / TEXT("LoadTest") /
+		FString::Printf(TEXT("LoadTest-%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(
+		TEXT("Bots,Connections,Frames,AvgFrameMs,MaxFrameMs,AvgGameThreadMs,AvgPhysicsMs\n"),
+		*CsvPath);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ULoadTestSubsystem::OnWorldPostActorTick);
+}
+
+void ULoadTestSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	if (StartPhysicsTick.IsTickFunctionRegistered())
+	{
+		StartPhysicsTick.UnRegisterTickFunction();
+	}
+	if (EndPhysicsTick.IsTickFunctionRegistered())
+	{
+		EndPhysicsTick.UnRegisterTickFunction();
+	}
+
+	Super::Deinitialize();
+}
+
+void ULoadTestSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || !IsRunning())
+	{
+		return;
+	}
+	// 机器人只在服务器上生成
+	if (World->GetNetMode() == NM_Client)
+	{
+		Stages.Reset();
+		return;
+	}
+
+	if (!bStageStarted)
+	{
+		if (!World->GetAuthGameMode())
+		{
+			return;
+		}
+		StartStage();
+		return;
+	}
+
+	StageTime += DeltaSeconds;
+	if (StageTime < WarmupSeconds)
+	{
+		return;
+	}
+
+	Sample();
+	if (StageTime < WarmupSeconds + StageSeconds)
+	{
+		return;
+	}
+
+	WriteStage();
+	StageIndex++;
+	bStageStarted = false;
+	if (!IsRunning())
+	{
+		UE_LOG(LogTemp, Display, TEXT("Load test finished, results in %s"), *FPaths::ConvertRelativePathToFull(CsvPath));
+		SetNumBots(0);
+		if (bExitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+}
+
+void ULoadTestSubsystem::StartStage()
+{
+	if (!StartPhysicsTick.IsTickFunctionRegistered())
+	{
+		StartPhysicsTick.Stamp = &StartPhysicsTime;
+		StartPhysicsTick.TickGroup = TG_StartPhysics;
+		StartPhysicsTick.bCanEverTick = true;
+		StartPhysicsTick.RegisterTickFunction(GetWorld()->PersistentLevel);
+
+		EndPhysicsTick.Stamp = &EndPhysicsTime;
+		EndPhysicsTick.TickGroup = TG_EndPhysics;
+		EndPhysicsTick.bCanEverTick = true;
+		EndPhysicsTick.RegisterTickFunction(GetWorld()->PersistentLevel);
+	}
+
+	SetNumBots(Stages[StageIndex]);
+	StageTime = 0.f;
+	Samples = FStageSamples();
+	bStageStarted = true;
+
+	UE_LOG(LogTemp, Display, TEXT("Load test stage %d/%d: %d bots"), StageIndex + 1, Stages.Num(), Stages[StageIndex]);
+}
+
+void ULoadTestSubsystem::SetNumBots(int32 NumBots)
+{
+	UWorld* World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+
+	while (Bots.Num() < NumBots && GameMode)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.ObjectFlags |= RF_Transient;
+		AFPSCppBotController* Bot = World->SpawnActor<AFPSCppBotController>(SpawnInfo);
+		Bot->SetSeed(Bots.Num());
+		Bots.Add(Bot);
+		GameMode->RestartPlayer(Bot);
+	}
+
+	while (Bots.Num() > NumBots)
+	{
+		AFPSCppBotController* Bot = Bots.Pop();
+		if (!Bot)
+		{
+			continue;
+		}
+		APawn* BotPawn = Bot->GetPawn();
+		Bot->UnPossess();
+		if (UActorPoolSubsystem* ActorPool = World->GetSubsystem<UActorPoolSubsystem>())
+		{
+			ActorPool->Release(BotPawn);
+		}
+		else if (BotPawn)
+		{
+			BotPawn->Destroy();
+		}
+		Bot->Destroy();
+	}
+}
+
+void ULoadTestSubsystem::Sample()
+{
+	const double FrameMs = FApp::GetDeltaTime() * 1000.0;
+	Samples.NumFrames++;
+	Samples.FrameMs += FrameMs;
+	Samples.MaxFrameMs = FMath::Max(Samples.MaxFrameMs, FrameMs);
+	Samples.GameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	if (EndPhysicsTime > StartPhysicsTime)
+	{
+		Samples.PhysicsMs += (EndPhysicsTime - StartPhysicsTime) * 1000.0;
+	}
+
+	if (const UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		Samples.MaxConnections = FMath::Max(Samples.MaxConnections, NetDriver->ClientConnections.Num());
+	}
+}
+
+void ULoadTestSubsystem::WriteStage()
+{
+	const double Frames = FMath::Max(Samples.NumFrames, 1);
+	const FString Row = FString::Printf(TEXT("%d,%d,%d,%.3f,%.3f,%.3f,%.3f\n"),
+	                                    Stages[StageIndex], Samples.MaxConnections, Samples.NumFrames,
+	                                    Samples.FrameMs / Frames, Samples.MaxFrameMs,
+	                                    Samples.GameThreadMs / Frames, Samples.PhysicsMs / Frames);
+	FFileHelper::SaveStringToFile(Row, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(),
+	                              FILEWRITE_Append);
+	UE_LOG(LogTemp, Display, TEXT("Load test: %s"), *Row.TrimEnd());
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LoadTestSubsystem.generated.h"
+
+class AFPSCppBotController;
+
+/** Stamps the time its tick group starts, one at the start and one at the end of physics */
+USTRUCT()
+struct FLoadTestTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	double* Stamp = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override { return TEXT("FLoadTestTickFunction"); }
+};
+
+template <>
+struct TStructOpsTypeTraits<FLoadTestTickFunction> : public TStructOpsTypeTraitsBase2<FLoadTestTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * Headless load test, started on a server with -FPSCppLoadTest=8,32,64. Each stage fills the match
+ * with that many bots, waits WarmupSeconds, then records frame, game thread and physics time for
+ * StageSeconds. Every stage adds one row to a csv under Saved/Profiling/LoadTest.
+ * The bots are server side AI without client connections, so net bandwidth is not measured here.
+ */
+UCLASS(config=Game)
+class FPSCPP_API ULoadTestSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	bool IsRunning() const { return Stages.Num() > 0 && StageIndex < Stages.Num(); }
+
+	/** Seconds after the bot count changes before sampling starts */
+	UPROPERTY(config)
+	float WarmupSeconds = 10.f;
+
+	/** Seconds sampled per stage */
+	UPROPERTY(config)
+	float StageSeconds = 60.f;
+
+	/** Requests engine exit after the last stage */
+	UPROPERTY(config)
+	bool bExitWhenDone = true;
+
+private:
+	struct FStageSamples
+	{
+		int32 NumFrames = 0;
+		double FrameMs = 0.0;
+		double MaxFrameMs = 0.0;
+		double GameThreadMs = 0.0;
+		double PhysicsMs = 0.0;
+		int32 MaxConnections = 0;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void StartStage();
+
+	void SetNumBots(int32 NumBots);
+
+	void Sample();
+
+	void WriteStage();
+
+	/** Bot counts of each stage, parsed from the command line */
+	TArray<int32> Stages;
+
+	int32 StageIndex = 0;
+
+	float StageTime = 0.f;
+
+	bool bStageStarted = false;
+
+	FStageSamples Samples;
+
+	UPROPERTY(Transient)
+	TArray<AFPSCppBotController*> Bots;
+
+	FLoadTestTickFunction StartPhysicsTick;
+	FLoadTestTickFunction EndPhysicsTick;
+	double StartPhysicsTime = 0.0;
+	double EndPhysicsTime = 0.0;
+
+	FString CsvPath;
+
+	FDelegateHandle PostActorTickHandle;
+};
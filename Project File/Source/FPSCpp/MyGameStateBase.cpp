@@ -2,13 +2,74 @@
 
 
 #include "MyGameStateBase.h"
+#include "GameplayEventSubsystem.h"
+#include "ReplicationStats.h"
+#include "Net/UnrealNetwork.h"
 
 AMyGameStateBase::AMyGameStateBase()
 {
 	Score = 0;
 }
 
+void AMyGameStateBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		TargetHitHandle = Events->On<FTargetHitEvent>().AddUObject(this, &AMyGameStateBase::OnTargetHit);
+	}
+}
+
+void AMyGameStateBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->On<FTargetHitEvent>().Remove(TargetHitHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMyGameStateBase::OnTargetHit(const FTargetHitEvent& Event)
+{
+	AddScore(Event.Points);
+}
+
+void AMyGameStateBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMyGameStateBase, Score, Params);
+}
+
+void AMyGameStateBase::AddScore(int32 Points)
+{
+	SetScore(Score + Points);
+}
+
 void AMyGameStateBase::ResetScore()
 {
-	Score = 0;
+	SetScore(0);
+}
+
+void AMyGameStateBase::SetScore(int32 NewScore)
+{
+	if (Score != NewScore)
+	{
+		Score = NewScore;
+		FPSCPP_MARK_PROPERTY_DIRTY(AMyGameStateBase, Score, this);
+	}
+
+	OnRep_Score();
+}
+
+void AMyGameStateBase::OnRep_Score()
+{
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->Post(FScoreChangedEvent{Score});
+	}
 }
@@ -6,6 +6,8 @@
 #include "GameFramework/GameStateBase.h"
 #include "MyGameStateBase.generated.h"
 
+struct FTargetHitEvent;
+
 /**
  * 
  */
@@ -15,10 +17,29 @@ class FPSCPP_API AMyGameStateBase : public AGameStateBase
 	GENERATED_BODY()
 
 public:
-	UPROPERTY(BlueprintReadWrite)
+	// 蓝图直接写Score不会发FScoreChangedEvent, C++里走AddScore/ResetScore
+	UPROPERTY(BlueprintReadWrite, ReplicatedUsing=OnRep_Score)
 	int Score;
 
 public:
 	AMyGameStateBase();
 	void ResetScore();
+
+	void AddScore(int32 Points);
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION()
+	void OnRep_Score();
+
+private:
+	void SetScore(int32 NewScore);
+
+	void OnTargetHit(const FTargetHitEvent& Event);
+
+	FDelegateHandle TargetHitHandle;
 };
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerStateWidgetBase.h"
+#include "GameplayEventSubsystem.h"
+#include "MyGameStateBase.h"
+
+void UPlayerStateWidgetBase::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		AmmoChangedHandle = Events->On<FAmmoChangedEvent>().AddUObject(this, &UPlayerStateWidgetBase::HandleAmmoChanged);
+		ScoreChangedHandle = Events->On<FScoreChangedEvent>().AddUObject(this, &UPlayerStateWidgetBase::HandleScoreChanged);
+	}
+
+	// 创建时先显示一次当前分数, 之后只在事件到来时刷新
+	if (const AMyGameStateBase* GameState = GetWorld()->GetGameState<AMyGameStateBase>())
+	{
+		OnScoreChanged(GameState->Score);
+	}
+}
+
+void UPlayerStateWidgetBase::NativeDestruct()
+{
+	if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
+	{
+		Events->On<FAmmoChangedEvent>().Remove(AmmoChangedHandle);
+		Events->On<FScoreChangedEvent>().Remove(ScoreChangedHandle);
+	}
+
+	Super::NativeDestruct();
+}
+
+void UPlayerStateWidgetBase::HandleAmmoChanged(const FAmmoChangedEvent& Event)
+{
+	// 只显示自己的弹药
+	if (Event.Owner.Get() == GetOwningPlayerPawn())
+	{
+		OnAmmoChanged(Event.CurrentAmmo, Event.FullAmmo, Event.GrenadeCount);
+	}
+}
+
+void UPlayerStateWidgetBase::HandleScoreChanged(const FScoreChangedEvent& Event)
+{
+	OnScoreChanged(Event.Score);
+}
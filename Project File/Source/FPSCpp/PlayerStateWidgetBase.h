@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "PlayerStateWidgetBase.generated.h"
+
+struct FAmmoChangedEvent;
+struct FScoreChangedEvent;
+
+/**
+ * Base for the player state HUD widget. It is told about ammo and score changes through the gameplay
+ * event bus, so the blueprint only has to update its text in the events below instead of binding to
+ * the character every frame.
+ */
+UCLASS(Abstract)
+class FPSCPP_API UPlayerStateWidgetBase : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnAmmoChanged(int32 CurrentAmmo, int32 FullAmmo, int32 GrenadeCount);
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnScoreChanged(int32 Score);
+
+private:
+	void HandleAmmoChanged(const FAmmoChangedEvent& Event);
+
+	void HandleScoreChanged(const FScoreChangedEvent& Event);
+
+	FDelegateHandle AmmoChangedHandle;
+	FDelegateHandle ScoreChangedHandle;
+};
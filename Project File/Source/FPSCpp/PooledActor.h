@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PooledActor.generated.h"
+
+UINTERFACE(MinimalAPI)
+class UPooledActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Actors recycled by UActorPoolSubsystem. A freshly spawned actor goes through BeginPlay as usual,
+ * a reused one only gets OnPooledActivate, so both paths must leave the actor in the same state.
+ */
+class FPSCPP_API IPooledActor
+{
+	GENERATED_BODY()
+
+public:
+	/** Taken out of the pool, the actor has already been moved to its spawn transform */
+	virtual void OnPooledActivate() = 0;
+
+	/** Returned to the pool, stop timers and movement and hide the actor */
+	virtual void OnPooledDeactivate() = 0;
+};
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ReplicationStats.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/CoreNet.h"
+
+static TMap<TPair<FName, FName>, int32> DirtyCounts;
+
+void FReplicationStats::RecordDirty(const UClass* Class, FName PropertyName)
+{
+	DirtyCounts.FindOrAdd(TPair<FName, FName>(Class->GetFName(), PropertyName))++;
+}
+
+static const TCHAR* LexConditionName(ELifetimeCondition Condition)
+{
+	switch (Condition)
+	{
+	case COND_None: return TEXT("None");
+	case COND_InitialOnly: return TEXT("InitialOnly");
+	case COND_OwnerOnly: return TEXT("OwnerOnly");
+	case COND_SkipOwner: return TEXT("SkipOwner");
+	case COND_SimulatedOnly: return TEXT("SimulatedOnly");
+	case COND_AutonomousOnly: return TEXT("AutonomousOnly");
+	default: return TEXT("Other");
+	}
+}
+
+static bool IsModuleProperty(const FProperty* Property)
+{
+	static const FName ModulePackage(TEXT("/Script/FPSCpp"));
+	const UClass* OwnerClass = Property->GetOwnerClass();
+	return OwnerClass && OwnerClass->GetOutermost()->GetFName() == ModulePackage;
+}
+
+static int64 ReportObject(UObject* Object)
+{
+	UClass* Class = Object->GetClass();
+
+	TArray<FLifetimeProperty> LifetimeProps;
+	Object->GetLifetimeReplicatedProps(LifetimeProps);
+	Class->SetUpRuntimeReplicationData();
+
+	int64 TotalBytes = 0;
+	bool bHeader = false;
+	for (const FLifetimeProperty& LifetimeProp : LifetimeProps)
+	{
+		if (!Class->ClassReps.IsValidIndex(LifetimeProp.RepIndex))
+		{
+			continue;
+		}
+		FProperty* Property = Class->ClassReps[LifetimeProp.RepIndex].Property;
+		if (!IsModuleProperty(Property))
+		{
+			continue;
+		}
+
+		if (!bHeader)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%s"), *Class->GetName());
+			bHeader = true;
+		}
+
+		FNetBitWriter Writer(nullptr, 0);
+		Property->NetSerializeItem(Writer, nullptr, Property->ContainerPtrToValuePtr<void>(Object));
+		const int64 Bits = Writer.GetNumBits();
+
+		const int32* Dirty = DirtyCounts.Find(TPair<FName, FName>(Property->GetOwnerClass()->GetFName(), Property->GetFName()));
+		const int32 NumDirty = Dirty ? *Dirty : 0;
+		const int64 Bytes = (Bits * NumDirty + 7) / 8;
+		TotalBytes += Bytes;
+
+		UE_LOG(LogTemp, Display, TEXT("  %-24s cond=%-14s push=%d size=%3lld bits dirty=%6d est=%8lld bytes"),
+		       *Property->GetName(), LexConditionName(LifetimeProp.Condition), LifetimeProp.bIsPushBased ? 1 : 0,
+		       Bits, NumDirty, Bytes);
+	}
+	return TotalBytes;
+}
+
+void FReplicationStats::Report(UWorld* World, bool bReset)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	// 每个类只测一个实例, 本模块的属性大小不随实例变化
+	TSet<const UClass*> Reported;
+	int64 TotalBytes = 0;
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		TInlineComponentArray<UActorComponent*> Components(*It);
+		TArray<UObject*, TInlineAllocator<8>> Objects;
+		Objects.Add(*It);
+		Objects.Append(Components);
+
+		for (UObject* Object : Objects)
+		{
+			if (!Reported.Contains(Object->GetClass()))
+			{
+				Reported.Add(Object->GetClass());
+				TotalBytes += ReportObject(Object);
+			}
+		}
+	}
+	UE_LOG(LogTemp, Display, TEXT("Total estimated payload: %lld bytes per connection"), TotalBytes);
+
+	if (bReset)
+	{
+		DirtyCounts.Reset();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PropertyReportCommand(
+	TEXT("fpscpp.Net.PropertyReport"),
+	TEXT("Logs every replicated FPSCpp property with its condition, serialized size, dirty count and estimated bytes. Usage: fpscpp.Net.PropertyReport [reset]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FReplicationStats::Report(World, Args.Num() > 0 && Args[0] == TEXT("reset"));
+	}));
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+/** Marks a push-model property dirty and counts the mark for fpscpp.Net.PropertyReport */
+#define FPSCPP_MARK_PROPERTY_DIRTY(ClassName, PropertyName, Object) \
+	do \
+	{ \
+		MARK_PROPERTY_DIRTY_FROM_NAME(ClassName, PropertyName, Object); \
+		FReplicationStats::RecordDirty(ClassName::StaticClass(), GET_MEMBER_NAME_CHECKED(ClassName, PropertyName)); \
+	} while (0)
+
+/**
+ * Counts how often each push-model property is marked dirty. fpscpp.Net.PropertyReport combines the
+ * counts with each property's serialized size to estimate the bytes it cost since the last reset.
+ */
+struct FPSCPP_API FReplicationStats
+{
+	static void RecordDirty(const UClass* Class, FName PropertyName);
+
+	static void Report(UWorld* World, bool bReset);
+};
@@ -2,14 +2,23 @@
 
 
 #include "Target.h"
-#include "MyGameStateBase.h"
+#include "FPSCpp.h"
+#include "FPSCppMemory.h"
+#include "DamageRegistrySubsystem.h"
+#include "GameplayEventSubsystem.h"
+#include "TargetField.h"
 #include "GameFramework/ProjectileMovementComponent.h"
+#include "Materials/MaterialInterface.h"
+
+DECLARE_CYCLE_STAT(TEXT("Target Hitted"), STAT_TargetHitted, STATGROUP_FPSCpp);
 
 // Sets default values
 ATarget::ATarget()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	//只在命中状态渐变时tick
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	RootCapsule = CreateDefaultSubobject<UCapsuleComponent>(TEXT("RootCapsule"));
 	RootComponent = RootCapsule;
@@ -23,6 +32,19 @@ ATarget::ATarget()
 
 	PhysicsConstraintComponent = CreateDefaultSubobject<UPhysicsConstraintComponent>(TEXT("PhysicsConstraint"));
 	PhysicsConstraintComponent->SetupAttachment(RootCapsule);
+
+	OwningField = nullptr;
+
+	HitFadeTime = 0.25f;
+	HitStateParameter = TEXT("HitState");
+	bSwapMaterialOnHit = false;
+	HitState = 0.f;
+	HitStateGoal = 0.f;
+
+	// 池里的靶子休眠, 激活时才开始复制
+	bReplicates = true;
+	SetReplicatingMovement(true);
+	NetDormancy = DORM_DormantAll;
 }
 
 // Called when the game starts or when spawned
@@ -30,12 +52,71 @@ void ATarget::BeginPlay()
 {
 	Super::BeginPlay();
 	bShootable = true;
+	TargetRelativeTransform = Target->GetRelativeTransform();
+
+	//材质没有绑定自定义图元数据的参数时才退回到换材质
+	UMaterialInterface* Material = OriginMaterial ? OriginMaterial : Target->GetMaterial(0);
+	float DefaultHitState;
+	bSwapMaterialOnHit = ShootedMaterial && !(Material && Material->GetScalarParameterValue(
+		FHashedMaterialParameterInfo(HitStateParameter), DefaultHitState));
+	if (bSwapMaterialOnHit)
+	{
+		UE_LOG(LogFPSCpp, Verbose, TEXT("%s: target material has no %s parameter, swapping materials on hit"),
+		       *GetName(), *HitStateParameter.ToString());
+	}
+
+	if (UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>())
+	{
+		Registry->Register(this, this);
+	}
+}
+
+void ATarget::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+	{
+		Timers->ClearTimer(RebornTimerHandle);
+	}
+	if (UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>())
+	{
+		Registry->Unregister(this, this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void ATarget::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	const float FadeSpeed = HitFadeTime > 0.f ? 1.f / HitFadeTime : BIG_NUMBER;
+	HitState = FMath::FInterpConstantTo(HitState, HitStateGoal, DeltaTime, FadeSpeed);
+	Target->SetCustomPrimitiveDataFloat(HitStateDataIndex, HitState);
+
+	if (HitState == HitStateGoal)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void ATarget::FadeHitState(float NewHitState)
+{
+	HitStateGoal = NewHitState;
+	if (bSwapMaterialOnHit)
+	{
+		//材质不读自定义图元数据时退回到换材质
+		UMaterialInterface* Material = HitStateGoal > 0.f ? ShootedMaterial : OriginMaterial;
+		if (Material)
+		{
+			Target->SetMaterial(0, Material);
+		}
+		HitState = HitStateGoal;
+		return;
+	}
+
+	//命中反馈只改自定义图元数据, 共用同一个材质, 不会重建渲染状态
+	SetActorTickEnabled(HitState != HitStateGoal);
 }
 
 void ATarget::NotifyActorBeginOverlap(AActor* OtherActor)
@@ -49,32 +130,81 @@ void ATarget::NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveCo
 	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
 }
 
-void ATarget::Hitted()
+void ATarget::ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser)
 {
+	Hitted(DamageCauser);
+}
+
+void ATarget::Hitted(AActor* HitInstigator)
+{
+	FPSCPP_SCOPE_CYCLE_COUNTER(STAT_TargetHitted);
 	if (bShootable)
 	{
-		AMyGameStateBase* GS = Cast<AMyGameStateBase>(GetWorld()->GetGameState());
-		if (GS)
-		{
-			GS->Score++;
-		}
-		else
+		//计分交给事件的订阅者
+		if (UGameplayEventSubsystem* Events = GetWorld()->GetSubsystem<UGameplayEventSubsystem>())
 		{
-			UE_LOG(LogTemp, Warning, TEXT("NULL"));
+			Events->Post(FTargetHitEvent{this, HitInstigator, 1});
 		}
-		UE_LOG(LogTemp, Error, TEXT("%d"), GS->Score)
 
-		Target->SetMaterial(0,ShootedMaterial);
+		FadeHitState(1.f);
 
 		bShootable = false;
-		GetWorldTimerManager().SetTimer(RebornTimerHandle,this,&ATarget::Reborn,20.f,false);
+		if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+		{
+			RebornTimerHandle = Timers->SetTimer(this,&ATarget::Reborn,20.f);
+		}
 	}
 }
 
 void ATarget::Reborn()
 {
-	Target->SetMaterial(0,OriginMaterial);
+	FadeHitState(0.f);
+	bShootable = true;
+
+	if (OwningField)
+	{
+		OwningField->OnTargetReborn(this);
+	}
+}
+
+void ATarget::OnPooledActivate()
+{
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	//模拟物理时靶子会脱离父组件, 复用前挂回原位再重新建立约束
+	FPSCPP_LLM_SCOPE(EFPSCppLLMTag::Targets);
+	Target->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+	Target->SetRelativeTransform(TargetRelativeTransform);
+	Target->SetSimulatePhysics(true);
+	PhysicsConstraintComponent->InitComponentConstraint();
+
+	HitState = 0.f;
+	HitStateGoal = 0.f;
+	Target->SetCustomPrimitiveDataFloat(HitStateDataIndex, HitState);
+	if (bSwapMaterialOnHit && OriginMaterial)
+	{
+		Target->SetMaterial(0, OriginMaterial);
+	}
 	bShootable = true;
+	SetNetDormancy(DORM_Awake);
+}
+
+void ATarget::OnPooledDeactivate()
+{
+	if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+	{
+		Timers->ClearTimer(RebornTimerHandle);
+	}
+	OwningField = nullptr;
+	SetActorTickEnabled(false);
+	Target->SetPhysicsLinearVelocity(FVector::ZeroVector);
+	Target->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+	Target->SetSimulatePhysics(false);
+	PhysicsConstraintComponent->BreakConstraint();
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+	SetNetDormancy(DORM_DormantAll);
 }
 
 
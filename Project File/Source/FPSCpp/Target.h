@@ -3,14 +3,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "DamageReceiver.h"
+#include "GameplayTimerSubsystem.h"
+#include "PooledActor.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/Actor.h"
 #include "PhysicsEngine/PhysicsConstraintComponent.h"
 #include "Target.generated.h"
 
+class ATargetField;
+
 UCLASS()
-class FPSCPP_API ATarget : public AActor
+class FPSCPP_API ATarget : public AActor, public IDamageReceiver, public IPooledActor
 {
 	GENERATED_BODY()
 
@@ -34,15 +39,32 @@ public:
 	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category="Materials")
 	UMaterialInterface* OriginMaterial;
 
+	/** Fallback swapped in on hit, only used when the target material has no HitStateParameter */
 	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category="Materials")
 	UMaterialInterface* ShootedMaterial;
+
+	/** Custom primitive data slot the target material reads its hit state from, 0 idle, 1 hit */
+	static constexpr int32 HitStateDataIndex = 0;
+
+	/** Scalar parameter bound to HitStateDataIndex in the target material */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,Category="Materials")
+	FName HitStateParameter;
+
+	/** Seconds the hit state takes to fade between idle and hit */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,Category="Materials")
+	float HitFadeTime;
 	
 	bool bShootable;
-	FTimerHandle RebornTimerHandle;
+	FGameplayTimerHandle RebornTimerHandle;
+
+	/** Field this target was activated from, it is collapsed back into an instance on Reborn */
+	UPROPERTY()
+	ATargetField* OwningField;
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	// Called every frame
@@ -52,7 +74,23 @@ public:
 	                       FVector HitLocation, FVector HitNormal, FVector NormalImpulse,
 	                       const FHitResult& Hit) override;
 
-	void Hitted();
+	virtual void ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser) override;
+
+	void Hitted(AActor* HitInstigator = nullptr);
 
 	void Reborn();
+
+	virtual void OnPooledActivate() override;
+	virtual void OnPooledDeactivate() override;
+
+private:
+	void FadeHitState(float NewHitState);
+
+	/** The target material has no HitStateParameter, hit feedback swaps to ShootedMaterial */
+	bool bSwapMaterialOnHit;
+
+	FTransform TargetRelativeTransform;
+
+	float HitState;
+	float HitStateGoal;
 };
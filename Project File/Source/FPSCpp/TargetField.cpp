@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TargetField.h"
+#include "ActorPoolSubsystem.h"
+#include "DamageRegistrySubsystem.h"
+#include "ReplicationStats.h"
+#include "Target.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Net/UnrealNetwork.h"
+
+// Sets default values
+ATargetField::ATargetField()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	FieldRoot = CreateDefaultSubobject<USceneComponent>(TEXT("FieldRoot"));
+	RootComponent = FieldRoot;
+
+	// 空闲靶子只保留查询碰撞, 不创建刚体
+	AnchorInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("AnchorInstances"));
+	AnchorInstances->SetupAttachment(RootComponent);
+	AnchorInstances->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	AnchorInstances->SetMobility(EComponentMobility::Static);
+
+	TargetInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("TargetInstances"));
+	TargetInstances->SetupAttachment(RootComponent);
+	TargetInstances->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	TargetInstances->SetCollisionObjectType(ECC_WorldDynamic);
+	TargetInstances->SetMobility(EComponentMobility::Static);
+
+	ActivationImpulse = 50000.f;
+
+	// 靶场只在靶子激活和复位时变化, 其余时间保持休眠
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
+}
+
+void ATargetField::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	BuildInstances();
+}
+
+void ATargetField::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		ActiveTargets.SetNumZeroed(TargetTransforms.Num());
+	}
+	HiddenInstances.Init(false, TargetTransforms.Num());
+
+	if (UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>())
+	{
+		Registry->Register(this, this);
+	}
+}
+
+void ATargetField::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UDamageRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDamageRegistrySubsystem>())
+	{
+		Registry->Unregister(this, this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATargetField::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ATargetField, ActiveTargets, Params);
+}
+
+void ATargetField::BuildInstances()
+{
+	AnchorInstances->ClearInstances();
+	TargetInstances->ClearInstances();
+
+	const ATarget* Defaults = TargetClass ? TargetClass->GetDefaultObject<ATarget>() : nullptr;
+	if (!Defaults)
+	{
+		return;
+	}
+
+	// 实例的网格体、材质和相对位置都取自靶子类的默认对象
+	AnchorOffset = Defaults->Anchor->GetRelativeTransform();
+	TargetOffset = Defaults->Target->GetRelativeTransform();
+	AnchorInstances->SetStaticMesh(Defaults->Anchor->GetStaticMesh());
+	TargetInstances->SetStaticMesh(Defaults->Target->GetStaticMesh());
+	if (Defaults->OriginMaterial)
+	{
+		TargetInstances->SetMaterial(0, Defaults->OriginMaterial);
+	}
+
+	for (int32 Index = 0; Index < TargetTransforms.Num(); ++Index)
+	{
+		AnchorInstances->AddInstance(GetInstanceTransform(Index, AnchorOffset));
+		TargetInstances->AddInstance(GetInstanceTransform(Index, TargetOffset));
+	}
+}
+
+FTransform ATargetField::GetInstanceTransform(int32 Index, const FTransform& ComponentOffset) const
+{
+	return ComponentOffset * TargetTransforms[Index];
+}
+
+void ATargetField::ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser)
+{
+	if (HitResult.GetComponent() != TargetInstances && HitResult.GetComponent() != AnchorInstances)
+	{
+		return;
+	}
+
+	const int32 Index = HitResult.Item;
+	if (ActiveTargets.IsValidIndex(Index) && !ActiveTargets[Index])
+	{
+		ActivateTarget(Index, HitResult, DamageCauser);
+	}
+}
+
+void ATargetField::ActivateTarget(int32 Index, const FHitResult& HitResult, AActor* DamageCauser)
+{
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	if (!ActorPool)
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = this;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const FTransform WorldTransform = TargetTransforms[Index] * GetActorTransform();
+	ATarget* ActiveTarget = ActorPool->Acquire<ATarget>(TargetClass, WorldTransform, SpawnParameters);
+	if (!ActiveTarget)
+	{
+		return;
+	}
+
+	ActiveTargets[Index] = ActiveTarget;
+	ActiveTarget->OwningField = this;
+	MarkActiveTargetsDirty();
+	if (SetInstanceHidden(Index, true))
+	{
+		MarkInstancesRenderStateDirty();
+	}
+
+	ActiveTarget->Hitted(DamageCauser);
+
+	const FVector ShotDirection = (HitResult.TraceEnd - HitResult.TraceStart).GetSafeNormal();
+	if (!ShotDirection.IsNearlyZero() && ActiveTarget->Target->IsSimulatingPhysics())
+	{
+		ActiveTarget->Target->AddImpulseAtLocation(ShotDirection * ActivationImpulse, HitResult.ImpactPoint);
+	}
+}
+
+void ATargetField::OnTargetReborn(ATarget* RebornTarget)
+{
+	const int32 Index = ActiveTargets.Find(RebornTarget);
+	if (Index != INDEX_NONE)
+	{
+		CollapseTarget(Index);
+	}
+}
+
+void ATargetField::CollapseTarget(int32 Index)
+{
+	ATarget* ActiveTarget = ActiveTargets[Index];
+	ActiveTargets[Index] = nullptr;
+	MarkActiveTargetsDirty();
+	if (SetInstanceHidden(Index, false))
+	{
+		MarkInstancesRenderStateDirty();
+	}
+
+	if (ActiveTarget)
+	{
+		ActiveTarget->OwningField = nullptr;
+		if (UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+		{
+			ActorPool->Release(ActiveTarget);
+		}
+	}
+}
+
+bool ATargetField::SetInstanceHidden(int32 Index, bool bHidden)
+{
+	if (!HiddenInstances.IsValidIndex(Index) || HiddenInstances[Index] == bHidden)
+	{
+		return false;
+	}
+	HiddenInstances[Index] = bHidden;
+
+	// 缩放为0隐藏实例, 保持实例下标不变. 命中的实例会被actor替换, 实例本身不需要命中状态
+	if (bHidden)
+	{
+		const FTransform HiddenTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+		AnchorInstances->UpdateInstanceTransform(Index, HiddenTransform, false, false);
+		TargetInstances->UpdateInstanceTransform(Index, HiddenTransform, false, false);
+	}
+	else
+	{
+		AnchorInstances->UpdateInstanceTransform(Index, GetInstanceTransform(Index, AnchorOffset), false, false);
+		TargetInstances->UpdateInstanceTransform(Index, GetInstanceTransform(Index, TargetOffset), false, false);
+	}
+	return true;
+}
+
+void ATargetField::MarkInstancesRenderStateDirty()
+{
+	AnchorInstances->MarkRenderStateDirty();
+	TargetInstances->MarkRenderStateDirty();
+}
+
+void ATargetField::MarkActiveTargetsDirty()
+{
+	FPSCPP_MARK_PROPERTY_DIRTY(ATargetField, ActiveTargets, this);
+	FlushNetDormancy();
+}
+
+void ATargetField::OnRep_ActiveTargets()
+{
+	// 还没复制过来的靶子指针为空, 实例先保持显示
+	bool bChanged = false;
+	for (int32 Index = 0; Index < ActiveTargets.Num(); ++Index)
+	{
+		bChanged |= SetInstanceHidden(Index, ActiveTargets[Index] != nullptr);
+	}
+	if (bChanged)
+	{
+		MarkInstancesRenderStateDirty();
+	}
+}
+
+int32 ATargetField::GetNumActiveTargets() const
+{
+	int32 NumActive = 0;
+	for (const ATarget* ActiveTarget : ActiveTargets)
+	{
+		NumActive += ActiveTarget ? 1 : 0;
+	}
+	return NumActive;
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DamageReceiver.h"
+#include "GameFramework/Actor.h"
+#include "TargetField.generated.h"
+
+class ATarget;
+class UHierarchicalInstancedStaticMeshComponent;
+
+/**
+ * A shooting range of ATargets drawn as instances. Idle targets are query-only instances without a
+ * physics body. A hit swaps the instance for a pooled, simulating ATarget, which collapses back into
+ * its instance once it has been reborn.
+ */
+UCLASS()
+class FPSCPP_API ATargetField : public AActor, public IDamageReceiver
+{
+	GENERATED_BODY()
+
+public:
+	ATargetField();
+
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category=Target)
+	TSubclassOf<ATarget> TargetClass;
+
+	/** Target placements relative to the field */
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category=Target,meta=(MakeEditWidget=true))
+	TArray<FTransform> TargetTransforms;
+
+	/** Impulse applied to the target mesh when an instance turns into an actor */
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category=Target)
+	float ActivationImpulse;
+
+	UPROPERTY(VisibleAnywhere,BlueprintReadOnly)
+	USceneComponent* FieldRoot;
+
+	UPROPERTY(VisibleAnywhere,BlueprintReadOnly)
+	UHierarchicalInstancedStaticMeshComponent* AnchorInstances;
+
+	UPROPERTY(VisibleAnywhere,BlueprintReadOnly)
+	UHierarchicalInstancedStaticMeshComponent* TargetInstances;
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void ReceiveDamage(float Damage, const FHitResult& HitResult, AActor* DamageCauser) override;
+
+	/** Called by an activated target once Reborn() has run */
+	void OnTargetReborn(ATarget* RebornTarget);
+
+	int32 GetNumActiveTargets() const;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// 基准测试直接激活和回收靶子
+	friend class UBenchmarkSubsystem;
+
+	void BuildInstances();
+
+	void ActivateTarget(int32 Index, const FHitResult& HitResult, AActor* DamageCauser);
+
+	void CollapseTarget(int32 Index);
+
+	FTransform GetInstanceTransform(int32 Index, const FTransform& ComponentOffset) const;
+
+	/** Hides the placement's instances while its actor is active, on the server and on clients. Returns false when nothing changed */
+	bool SetInstanceHidden(int32 Index, bool bHidden);
+
+	/** Pushes the instance transforms changed by SetInstanceHidden to the renderer once per batch */
+	void MarkInstancesRenderStateDirty();
+
+	/** Wakes the field from dormancy for one update with the new ActiveTargets */
+	void MarkActiveTargetsDirty();
+
+	UFUNCTION()
+	void OnRep_ActiveTargets();
+
+	/** Simulated actor per placement, null while the placement is drawn as an instance */
+	UPROPERTY(ReplicatedUsing=OnRep_ActiveTargets)
+	TArray<ATarget*> ActiveTargets;
+
+	TBitArray<> HiddenInstances;
+
+	FTransform AnchorOffset;
+	FTransform TargetOffset;
+};